@@ -9,6 +9,7 @@
 #include <latch>
 #include <limits>
 #include <map>
+#include <optional>
 #include <random>
 #include <set>
 #include <stdexcept>
@@ -34,6 +35,14 @@ static size_t MAX_OPS_PER_TXN = 10;
 static unsigned SCAN_PERCENTAGE = 25;
 static unsigned WRITE_PERCENTAGE = 10;
 static size_t SCAN_RANGE = 0;
+static bool AUTO_RETRY = false;
+static unsigned HV_MAX_HEIGHT = 0;
+static unsigned HV_STRIPE_HEIGHT = 0;
+static bool SCAN_READ_ONLY = false;
+static bool SCAN_SNAPSHOT = false;
+static garner::TxnIsolation ISOLATION = garner::ISOLATION_SERIALIZABLE;
+static double ZIPF_THETA = 0.;
+static bool HOT_LOCKING = false;
 
 struct TxnStats {
     size_t num_txns = 0;
@@ -55,6 +64,11 @@ static void client_thread_func(std::stop_token stop_token,
     std::string val = gen_rand_string(gen, VAL_LEN);
 
     std::uniform_int_distribution<size_t> rand_idx(0, warmup_keys->size() - 1);
+    std::optional<ZipfianDistribution> zipf_idx;
+    if (ZIPF_THETA > 0.) zipf_idx.emplace(warmup_keys->size(), ZIPF_THETA);
+    auto RandPointIdx = [&]() -> size_t {
+        return zipf_idx ? (*zipf_idx)(gen) : rand_idx(gen);
+    };
     std::uniform_int_distribution<size_t> rand_scan_idx(
         0, warmup_keys->size() - SCAN_RANGE - 1);
 
@@ -71,11 +85,11 @@ static void client_thread_func(std::stop_token stop_token,
                 : (rand_is_write_op(gen) <= WRITE_PERCENTAGE) ? PUT : GET;
 
         if (op == GET) {
-            std::string key = warmup_keys->at(rand_idx(gen));
+            std::string key = warmup_keys->at(RandPointIdx());
             return GarnerReq(GET, std::move(key), "", "");
 
         } else if (op == PUT) {
-            std::string key = warmup_keys->at(rand_idx(gen));
+            std::string key = warmup_keys->at(RandPointIdx());
             return GarnerReq(PUT, std::move(key), "", val);
 
         } else {
@@ -104,6 +118,23 @@ static void client_thread_func(std::stop_token stop_token,
     std::vector<std::tuple<std::string, std::string>> scan_result;
     size_t scan_nrecords;
 
+    std::vector<GarnerReq> txn_reqs;
+    auto RunTxnBody = [&](garner::TxnCxt<std::string, std::string>* txn) {
+        for (auto&& req : txn_reqs) {
+            // no point issuing more ops if the txn is known to abort
+            if (gn->TxnDoomed(txn)) break;
+
+            if (req.op == GET) {
+                gn->Get(req.key, get_buf, get_found, txn);
+            } else if (req.op == PUT) {
+                gn->Put(req.key, req.value, txn);
+            } else {
+                gn->Scan(req.key, req.rkey, scan_result, scan_nrecords, txn);
+                scan_result.clear();
+            }
+        }
+    };
+
     // sync all client threads here before doing work
     init_barrier->count_down();
     init_barrier->wait();
@@ -120,25 +151,33 @@ static void client_thread_func(std::stop_token stop_token,
         // generate number of ops for this transaction
         size_t txn_ops = scan_txn ? rand_txn_ops_scan(gen) : rand_txn_ops(gen);
 
-        auto* txn = gn->StartTxn();
+        // generate random requests
+        txn_reqs.clear();
+        for (size_t j = 0; j < txn_ops; ++j)
+            txn_reqs.push_back(GenRandomReq(scan_txn));
+
+        // if auto retry enabled, let Garner re-execute aborted txns
+        if (AUTO_RETRY) {
+            unsigned nretries = 0;
+            bool committed = gn->RunTxn(RunTxnBody, garner::RetryPolicy(),
+                                        &nretries);
+            stats->num_txns += 1 + nretries;
+            if (committed) ++stats->num_committed;
+            continue;
+        }
+
+        garner::TxnMode mode = garner::TXN_READ_WRITE;
+        if (scan_txn && SCAN_SNAPSHOT)
+            mode = garner::TXN_SNAPSHOT;
+        else if (scan_txn && SCAN_READ_ONLY)
+            mode = garner::TXN_READ_ONLY;
+        auto* txn = gn->StartTxn(mode, ISOLATION);
 
         std::chrono::time_point<std::chrono::high_resolution_clock> start_tp;
         if constexpr (build_options.txn_stat)
             start_tp = std::chrono::high_resolution_clock::now();
 
-        // generate random requests
-        for (size_t j = 0; j < txn_ops; ++j) {
-            GarnerReq req = GenRandomReq(scan_txn);
-
-            if (req.op == GET) {
-                gn->Get(req.key, get_buf, get_found, txn);
-            } else if (req.op == PUT) {
-                gn->Put(req.key, req.value, txn);
-            } else {
-                gn->Scan(req.key, req.rkey, scan_result, scan_nrecords, txn);
-                scan_result.clear();
-            }
-        }
+        RunTxnBody(txn);
 
         bool committed;
         if constexpr (!build_options.txn_stat)
@@ -168,12 +207,24 @@ static void client_thread_func(std::stop_token stop_token,
 }
 
 static void simple_benchmark_round(garner::TxnProtocol protocol) {
-    auto* gn = garner::Garner::Open(TEST_DEGREE, protocol);
+    auto* gn = garner::Garner::Open(TEST_DEGREE, protocol, HV_MAX_HEIGHT, 0,
+                                    HV_STRIPE_HEIGHT, HOT_LOCKING);
 
     std::cout << " Degree=" << TEST_DEGREE << " #threads=" << NUM_THREADS
               << " length=" << ROUND_SECS << "s"
               << " scan=" << SCAN_PERCENTAGE << "%"
-              << " write=" << WRITE_PERCENTAGE << "%" << std::endl;
+              << " write=" << WRITE_PERCENTAGE << "%"
+              << " hv_max_height=" << HV_MAX_HEIGHT
+              << " hv_stripe_height=" << HV_STRIPE_HEIGHT
+              << " read_only=" << (SCAN_READ_ONLY ? "yes" : "no")
+              << " snapshot=" << (SCAN_SNAPSHOT ? "yes" : "no")
+              << " isolation="
+              << (ISOLATION == garner::ISOLATION_SNAPSHOT ? "snapshot"
+                  : ISOLATION == garner::ISOLATION_READ_COMMITTED
+                      ? "read_committed"
+                      : "serializable")
+              << " zipf_theta=" << ZIPF_THETA
+              << " hot_locking=" << (HOT_LOCKING ? "yes" : "no") << std::endl;
 
     // garner::BPTreeStats stats = gn->GatherStats(true);
     // std::cout << stats << std::endl;
@@ -270,6 +321,7 @@ static void simple_benchmark_round(garner::TxnProtocol protocol) {
 int main(int argc, char* argv[]) {
     bool help;
     std::string protocol_str;
+    std::string isolation_str;
 
     cxxopts::Options cmd_args(argv[0]);
     cmd_args.add_options()("h,help", "print help message",
@@ -289,10 +341,33 @@ int main(int argc, char* argv[]) {
         "r,write_percent", "percentage of write operations",
         cxxopts::value<unsigned>(WRITE_PERCENTAGE)->default_value("10"))(
         "s,scan_range", "number of keys covered in each scan, 0 means random",
-        cxxopts::value<size_t>(SCAN_RANGE)->default_value("0"));
+        cxxopts::value<size_t>(SCAN_RANGE)->default_value("0"))(
+        "y,retry", "retry aborted transactions through RunTxn",
+        cxxopts::value<bool>(AUTO_RETRY)->default_value("false"))(
+        "v,hv_max_height",
+        "max height of pages tracked by HV protocols, 0 means from root",
+        cxxopts::value<unsigned>(HV_MAX_HEIGHT)->default_value("0"))(
+        "e,hv_stripe_height",
+        "min height of pages striping hv_sem per core, 0 means none",
+        cxxopts::value<unsigned>(HV_STRIPE_HEIGHT)->default_value("0"))(
+        "o,read_only", "start scan transactions in read-only mode",
+        cxxopts::value<bool>(SCAN_READ_ONLY)->default_value("false"))(
+        "n,snapshot", "start scan transactions in snapshot mode",
+        cxxopts::value<bool>(SCAN_SNAPSHOT)->default_value("false"))(
+        "i,isolation",
+        "isolation level of transactions not retried through RunTxn",
+        cxxopts::value<std::string>(isolation_str)
+            ->default_value("serializable"))(
+        "z,zipf_theta",
+        "Zipfian skew of point op keys in (0, 1), 0 means uniform",
+        cxxopts::value<double>(ZIPF_THETA)->default_value("0"))(
+        "k,hot_locking", "lock hot records at access time in Silo protocols",
+        cxxopts::value<bool>(HOT_LOCKING)->default_value("false"));
     auto result = cmd_args.parse(argc, argv);
 
-    std::set<std::string> valid_protocols{"none", "silo", "silo_hv", "silo_nr"};
+    std::set<std::string> valid_protocols{
+        "none",    "silo",       "silo_hv",    "silo_nr",
+        "silo_ad", "2pl_nowait", "2pl_waitdie", "tictoc"};
 
     if (help) {
         printf("%s", cmd_args.help().c_str());
@@ -311,12 +386,32 @@ int main(int argc, char* argv[]) {
         protocol = garner::PROTOCOL_SILO_HV;
     else if (protocol_str == "silo_nr")
         protocol = garner::PROTOCOL_SILO_NR;
+    else if (protocol_str == "silo_ad")
+        protocol = garner::PROTOCOL_SILO_AD;
+    else if (protocol_str == "2pl_nowait")
+        protocol = garner::PROTOCOL_2PL_NOWAIT;
+    else if (protocol_str == "2pl_waitdie")
+        protocol = garner::PROTOCOL_2PL_WAITDIE;
+    else if (protocol_str == "tictoc")
+        protocol = garner::PROTOCOL_TICTOC;
     else {
         std::cerr << "Error: unrecognized concurrency control protocol: "
                   << protocol_str << std::endl;
         return 1;
     }
 
+    if (isolation_str == "serializable")
+        ISOLATION = garner::ISOLATION_SERIALIZABLE;
+    else if (isolation_str == "snapshot")
+        ISOLATION = garner::ISOLATION_SNAPSHOT;
+    else if (isolation_str == "read_committed")
+        ISOLATION = garner::ISOLATION_READ_COMMITTED;
+    else {
+        std::cerr << "Error: unrecognized isolation level: " << isolation_str
+                  << std::endl;
+        return 1;
+    }
+
     if (MAX_OPS_PER_TXN < 10) {
         std::cerr << "Error: max number of ops per transaction too small "
                   << MAX_OPS_PER_TXN << std::endl;
@@ -332,6 +427,10 @@ int main(int argc, char* argv[]) {
                   << std::endl;
         return 1;
     }
+    if (ZIPF_THETA < 0. || ZIPF_THETA >= 1.) {
+        std::cerr << "Error: invalid Zipfian skew " << ZIPF_THETA << std::endl;
+        return 1;
+    }
 
     std::srand(std::time(NULL));
 
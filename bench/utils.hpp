@@ -1,4 +1,5 @@
 #include <cassert>
+#include <cmath>
 #include <random>
 #include <stdexcept>
 #include <string>
@@ -36,6 +37,38 @@ thread_local std::uniform_int_distribution<size_t> rand_idx(0,
     return str;
 }
 
+/**
+ * Zipfian distribution over [0, n) with skew theta in (0, 1), where 0 is the
+ * most popular item; Gray et al.'s method as used by YCSB.
+ */
+class ZipfianDistribution {
+    size_t n;
+    double theta, alpha, zetan, eta;
+
+    static double zeta(size_t n, double theta) {
+        double sum = 0.;
+        for (size_t i = 1; i <= n; ++i) sum += 1. / std::pow(i, theta);
+        return sum;
+    }
+
+   public:
+    ZipfianDistribution(size_t n, double theta)
+        : n(n), theta(theta), alpha(1. / (1. - theta)), zetan(zeta(n, theta)) {
+        assert(n > 1 && theta > 0. && theta < 1.);
+        eta = (1. - std::pow(2. / n, 1. - theta)) /
+              (1. - zeta(2, theta) / zetan);
+    }
+
+    size_t operator()(std::mt19937& gen) {
+        double u = std::uniform_real_distribution<double>(0., 1.)(gen);
+        double uz = u * zetan;
+        if (uz < 1.) return 0;
+        if (uz < 1. + std::pow(0.5, theta)) return 1;
+        size_t idx = static_cast<size_t>(n * std::pow(eta * u - eta + 1., alpha));
+        return std::min(idx, n - 1);
+    }
+};
+
 /**
  * Garner request struct for benchmarking.
  */
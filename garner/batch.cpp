@@ -0,0 +1,124 @@
+#include "batch.hpp"
+
+#include <cassert>
+#include <cstdint>
+
+#include <algorithm>
+#include <string>
+#include <thread>
+#include <unordered_map>
+
+#include "common.hpp"
+
+namespace garner {
+
+TxnBatch::TxnBatch(const std::vector<Garner::BatchTxn>& txns)
+    : txns(txns),
+      nodes(txns.size()),
+      mtx(),
+      cv(),
+      ready(),
+      nfinished(0),
+      first_error(nullptr) {
+    // per key, the last writer and the readers since then, in batch order
+    struct KeyState {
+        size_t last_writer = SIZE_MAX;
+        std::vector<size_t> readers;
+    };
+    std::unordered_map<Garner::KType, KeyState> key_states;
+
+    std::vector<size_t> preds;
+    for (size_t idx = 0; idx < txns.size(); ++idx) {
+        auto&& txn = txns[idx];
+        preds.clear();
+
+        for (auto&& key : txn.read_keys) {
+            // a key also written by me is handled as a write
+            if (std::find(txn.write_keys.begin(), txn.write_keys.end(), key) !=
+                txn.write_keys.end())
+                continue;
+            auto&& state = key_states[key];
+            if (state.last_writer != SIZE_MAX)
+                preds.push_back(state.last_writer);
+            if (state.readers.empty() || state.readers.back() != idx)
+                state.readers.push_back(idx);
+        }
+
+        for (auto&& key : txn.write_keys) {
+            auto&& state = key_states[key];
+            if (state.last_writer == idx) continue;
+            if (state.last_writer != SIZE_MAX)
+                preds.push_back(state.last_writer);
+            preds.insert(preds.end(), state.readers.begin(),
+                         state.readers.end());
+            state.last_writer = idx;
+            state.readers.clear();
+        }
+
+        std::sort(preds.begin(), preds.end());
+        preds.erase(std::unique(preds.begin(), preds.end()), preds.end());
+        for (size_t pred : preds) {
+            assert(pred < idx);
+            nodes[pred].successors.push_back(idx);
+        }
+        nodes[idx].npreds = preds.size();
+        if (preds.empty()) ready.push_back(idx);
+    }
+}
+
+void TxnBatch::WorkerLoop() {
+    std::unique_lock<std::mutex> lock(mtx);
+    while (true) {
+        cv.wait(lock,
+                [&] { return !ready.empty() || nfinished == txns.size(); });
+        if (ready.empty()) return;
+
+        size_t idx = ready.front();
+        ready.pop_front();
+
+        lock.unlock();
+        std::exception_ptr error = nullptr;
+        try {
+            txns[idx].body();
+        } catch (...) {
+            error = std::current_exception();
+        }
+        lock.lock();
+
+        // a failed body cannot be rolled back, so its successors still run
+        if (error != nullptr && first_error == nullptr) first_error = error;
+
+        size_t nready = 0;
+        for (size_t succ : nodes[idx].successors) {
+            assert(nodes[succ].npreds > 0);
+            if (--nodes[succ].npreds == 0) {
+                ready.push_back(succ);
+                nready++;
+            }
+        }
+
+        // keep one for myself, wake others for the rest
+        if (++nfinished == txns.size()) {
+            cv.notify_all();
+        } else {
+            for (size_t i = 1; i < nready; ++i) cv.notify_one();
+        }
+    }
+}
+
+void TxnBatch::Execute(unsigned nworkers) {
+    if (nworkers == 0)
+        throw GarnerException("batch execution needs at least one worker");
+    if (txns.empty()) return;
+
+    {
+        std::vector<std::jthread> workers;
+        for (unsigned widx = 0; widx < nworkers; ++widx)
+            workers.emplace_back([this] { WorkerLoop(); });
+    }
+
+    assert(nfinished == txns.size());
+    if (first_error != nullptr) std::rethrow_exception(first_error);
+}
+
+}  // namespace garner
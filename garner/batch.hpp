@@ -0,0 +1,67 @@
+// TxnBatch -- deterministic execution of a batch of transactions.
+
+#include <condition_variable>
+#include <cstddef>
+#include <deque>
+#include <exception>
+#include <mutex>
+#include <vector>
+
+#include "include/garner.hpp"
+
+#pragma once
+
+namespace garner {
+
+/**
+ * A batch of transactions with declared key sets, executed deterministically
+ * in the spirit of Calvin.
+ * https://dl.acm.org/doi/10.1145/2213836.2213838
+ *
+ * Upon construction, a conflict graph is built in batch order from the key
+ * sets: a transaction depends on the last earlier writer of each key it
+ * accesses, and a writer also on the readers since that writer. Execution
+ * then runs every transaction once all its dependencies have finished, on a
+ * pool of worker threads. The outcome is that of running the batch serially
+ * in order, without any validation or abort.
+ */
+class TxnBatch {
+   private:
+    /** Per-transaction node of the conflict graph. */
+    struct Node {
+        std::vector<size_t> successors;
+        size_t npreds = 0;  // number of unfinished predecessors
+    };
+
+    const std::vector<Garner::BatchTxn>& txns;
+    std::vector<Node> nodes;
+
+    // guards the fields below; bodies run without holding it
+    std::mutex mtx;
+    std::condition_variable cv;
+    std::deque<size_t> ready;
+    size_t nfinished = 0;
+    std::exception_ptr first_error = nullptr;
+
+    /**
+     * Body of worker threads.
+     */
+    void WorkerLoop();
+
+   public:
+    TxnBatch(const std::vector<Garner::BatchTxn>& txns);
+
+    TxnBatch(const TxnBatch&) = delete;
+    TxnBatch& operator=(const TxnBatch&) = delete;
+
+    ~TxnBatch() = default;
+
+    /**
+     * Run the batch to completion with given number of worker threads.
+     * Rethrows the first exception thrown by a body, after all others
+     * have run.
+     */
+    void Execute(unsigned nworkers);
+};
+
+}  // namespace garner
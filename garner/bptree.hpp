@@ -8,6 +8,7 @@
 #include <map>
 #include <mutex>
 #include <new>
+#include <optional>
 #include <set>
 #include <shared_mutex>
 #include <stdexcept>
@@ -38,6 +39,10 @@ class BPTree {
     // max number of keys per node page
     const size_t degree = 0;
 
+    // pages at or above this height, and the root, get their hv_sem striped
+    // per core; 0 means never
+    const unsigned hv_stripe_height = 0;
+
     // pointer to root page, set at initiailization
     PageRoot<K, V>* root = nullptr;
 
@@ -68,12 +73,17 @@ class BPTree {
      * leaf for read mode or the last few nodes for write mode), their internal
      * node traversal logic should be appropriately called later by the caller.
      *
+     * If parent_highkey is given, it is set to the highkey of the leaf's
+     * parent node as read under the parent's latch (nullopt if the parent is
+     * root or the rightmost at its level).
+     *
      * Returns a tuple of two vectors: (path, write_latched_pages)
      * - path: list of node pages starting from root to the searched leaf node.
      * - write_latched_pages: list of pages still latched in write mode
      */
     std::tuple<std::vector<Page<K>*>, std::vector<Page<K>*>> TraverseToLeaf(
-        const K& key, LatchMode latch_mode, TxnCxt<K, V>* txn = nullptr);
+        const K& key, LatchMode latch_mode, TxnCxt<K, V>* txn = nullptr,
+        std::optional<K>* parent_highkey = nullptr);
 
     /**
      * Split the given page into two siblings, and propagate one new key
@@ -90,6 +100,23 @@ class BPTree {
     void SplitPage(Page<K>* page, std::vector<Page<K>*>& path,
                    const K& trigger_key);
 
+    /**
+     * Traverse to the leaf for key in write mode and inject key into it,
+     * splitting as necessary. Calls txn's write traversal logic on the
+     * latched part of the path, and releases all page latches before
+     * returning the key's record.
+     */
+    Record<K, V>* InjectRecord(const K& key, TxnCxt<K, V>* txn);
+
+    /**
+     * Pin record on behalf of txn if it is a phantom. Must hold the latch
+     * of the leaf record was found in.
+     */
+    static void PinIfPhantom(Record<K, V>* record, TxnCxt<K, V>* txn) {
+        if (txn != nullptr && !Record<K, V>::TidValid(record->LoadTid()))
+            txn->PinPhantom(record);
+    }
+
     /**
      * Iterate through all pages in tree in depth-first post-order manner,
      * applying given function to each page.
@@ -98,7 +125,7 @@ class BPTree {
     void DepthFirstIterate(Func func);
 
    public:
-    BPTree(size_t degree);
+    BPTree(size_t degree, unsigned hv_stripe_height = 0);
     ~BPTree();
 
     /**
@@ -108,6 +135,17 @@ class BPTree {
      */
     void Put(K key, V value, TxnCxt<K, V>* txn);
 
+    /**
+     * Replace the value of key with fn applied to its current value and
+     * whether it exists, inserting key if not. If merge is true, the
+     * transaction does not observe the value, so fn may be deferred.
+     *
+     * Exceptions might be thrown.
+     */
+    void Update(const K& key,
+                const typename TxnCxt<K, V>::UpdateFn& fn,
+                TxnCxt<K, V>* txn, bool merge = false);
+
     /**
      * Search for a key, fill given reference with value.
      * Returns false if search failed or key not found.
@@ -134,6 +172,15 @@ class BPTree {
     size_t Scan(const K& lkey, const K& rkey,
                 std::vector<std::tuple<K, V>>& results, TxnCxt<K, V>* txn);
 
+    /**
+     * Unlink record from its leaf if it is still a phantom and nobody pins
+     * it, retiring it through epoch-based reclamation. A leaf other than
+     * the root keeps its last key. Must be called inside an epoch critical
+     * section entered while record was still pinned by the caller.
+     * Returns true if removed.
+     */
+    bool RemovePhantom(Record<K, V>* record);
+
     /**
      * Iterate through the whole B+-tree, gather and verify statistics. If
      * print_pages is true, also prints content of all pages.
@@ -5,7 +5,8 @@
 namespace garner {
 
 template <typename K, typename V>
-BPTree<K, V>::BPTree(size_t degree) : degree(degree) {
+BPTree<K, V>::BPTree(size_t degree, unsigned hv_stripe_height)
+    : degree(degree), hv_stripe_height(hv_stripe_height) {
     if (degree < 4) {
         throw GarnerException("degree parameter too small: " +
                               std::to_string(degree));
@@ -17,6 +18,9 @@ BPTree<K, V>::BPTree(size_t degree) : degree(degree) {
     root = new PageRoot<K, V>(degree);
     if (root == nullptr)
         throw GarnerException("failed to allocate memory for root page");
+
+    // root grows in place, and is always the hottest page of all
+    if (hv_stripe_height > 0) root->StripeHVSem();
 }
 
 template <typename K, typename V>
@@ -44,6 +48,7 @@ PageLeaf<K, V>* BPTree<K, V>::NewPageLeaf() {
     auto* page = new PageLeaf<K, V>(degree);
     if (page == nullptr)
         throw GarnerException("failed to allocate memory for new page");
+    if (hv_stripe_height == 1) page->StripeHVSem();
     return page;
 }
 
@@ -52,6 +57,8 @@ PageItnl<K, V>* BPTree<K, V>::NewPageItnl(unsigned height) {
     auto* page = new PageItnl<K, V>(degree, height);
     if (page == nullptr)
         throw GarnerException("failed to allocate memory for new page");
+    if (hv_stripe_height > 0 && height >= hv_stripe_height)
+        page->StripeHVSem();
     return page;
 }
 
@@ -64,7 +71,8 @@ bool BPTree<K, V>::IsConcurrencySafe(const Page<K>* page) const {
 template <typename K, typename V>
 std::tuple<std::vector<Page<K>*>, std::vector<Page<K>*>>
 BPTree<K, V>::TraverseToLeaf(const K& key, LatchMode latch_mode,
-                             TxnCxt<K, V>* txn) {
+                             TxnCxt<K, V>* txn,
+                             std::optional<K>* parent_highkey) {
     Page<K>* page = root;
     unsigned level = 0, height;
     std::vector<Page<K>*> path;
@@ -81,6 +89,7 @@ BPTree<K, V>::TraverseToLeaf(const K& key, LatchMode latch_mode,
 
     // read out height of tree, check if root is the only leaf
     height = reinterpret_cast<PageRoot<K, V>*>(page)->height;
+    if (parent_highkey != nullptr) parent_highkey->reset();
     if (height == 1) {
         path.push_back(page);
         // latch on root still held on return
@@ -109,6 +118,11 @@ BPTree<K, V>::TraverseToLeaf(const K& key, LatchMode latch_mode,
             // do concurrency control internal node traversal logic in
             // this function only for nodes not latched at return
             if (txn != nullptr) txn->ExecReadTraverseNode(page);
+            // if child is the leaf, remember its parent's highkey
+            if (parent_highkey != nullptr && level + 2 == height &&
+                page->type == PAGE_ITNL)
+                *parent_highkey =
+                    reinterpret_cast<PageItnl<K, V>*>(page)->highkey;
             page->latch.unlock_shared();
             DEBUG("page latch R release %p", static_cast<void*>(page));
 
@@ -146,6 +160,11 @@ BPTree<K, V>::TraverseToLeaf(const K& key, LatchMode latch_mode,
 template <typename K, typename V>
 void BPTree<K, V>::SplitPage(Page<K>* page, std::vector<Page<K>*>& path,
                              const K& trigger_key) {
+    // records under the split page may move out of its subtree, so readers
+    // that tracked it for hierarchical validation must not skip over it;
+    // give it a fresh version regardless of whether the writer commits
+    page->hv_ver.store(EpochManager::Global().NewCommitTid());
+
     if (page->type == PAGE_ROOT) {
         // if spliting root page, need to allocate two pages
         auto* spage = reinterpret_cast<PageRoot<K, V>*>(page);
@@ -160,11 +179,14 @@ void BPTree<K, V>::SplitPage(Page<K>* page, std::vector<Page<K>*>& path,
         if (spage->height == 1) {
             // special case of the very first split of root leaf
             DEBUG("split root leaf %p", static_cast<void*>(spage));
+            spage->node_ver.fetch_add(1, std::memory_order_release);
 
             auto* lpage = NewPageLeaf();
             auto* rpage = NewPageLeaf();
             lpage_saved = lpage;
             rpage_saved = rpage;
+            lpage->tictoc_rts.store(spage->tictoc_rts.load());
+            rpage->tictoc_rts.store(spage->tictoc_rts.load());
 
             // populate left child
             std::copy(spage->keys.begin(), spage->keys.begin() + mpos,
@@ -244,10 +266,12 @@ void BPTree<K, V>::SplitPage(Page<K>* page, std::vector<Page<K>*>& path,
         if (page->type == PAGE_LEAF) {
             // if splitting a non-root leaf node
             DEBUG("split leaf %p", static_cast<void*>(page));
+            page->node_ver.fetch_add(1, std::memory_order_release);
 
             auto* spage = reinterpret_cast<PageLeaf<K, V>*>(page);
             auto* rpage = NewPageLeaf();
             rpage_saved = rpage;
+            rpage->tictoc_rts.store(spage->tictoc_rts.load());
 
             // populate right child
             std::copy(spage->keys.begin() + mpos, spage->keys.end(),
@@ -379,11 +403,7 @@ void BPTree<K, V>::DepthFirstIterate(Func func) {
 }
 
 template <typename K, typename V>
-void BPTree<K, V>::Put(K key, V value, TxnCxt<K, V>* txn) {
-    DEBUG("req Put %s val %s", StreamStr(key).c_str(),
-          StreamStr(value).c_str());
-    if (txn != nullptr) txn->ExecEnterPut();
-
+Record<K, V>* BPTree<K, V>::InjectRecord(const K& key, TxnCxt<K, V>* txn) {
     // traverse to the correct leaf node and read
     std::vector<Page<K>*> path;
     std::vector<Page<K>*> write_latched_pages;
@@ -393,6 +413,7 @@ void BPTree<K, V>::Put(K key, V value, TxnCxt<K, V>* txn) {
 
     // inject key into the leaf node and get pointer to record
     assert(leaf->NumKeys() < degree);
+    size_t nkeys_before = leaf->NumKeys();
     Record<K, V>* record = nullptr;
     ssize_t idx = leaf->SearchKey(key);
     if (leaf->type == PAGE_ROOT)
@@ -400,9 +421,28 @@ void BPTree<K, V>::Put(K key, V value, TxnCxt<K, V>* txn) {
     else
         record = reinterpret_cast<PageLeaf<K, V>*>(leaf)->Inject(idx, key);
     assert(record != nullptr);
-
-    // if this leaf node becomes full, do split
-    if (leaf->NumKeys() >= degree) SplitPage(leaf, path, key);
+    PinIfPhantom(record, txn);
+
+    // if a new key got inserted, bump leaf's node version so that
+    // transactions that observed this leaf's key range notice the phantom
+    bool inserted = leaf->NumKeys() > nkeys_before;
+    uint64_t old_node_ver = 0;
+    if (inserted)
+        old_node_ver = leaf->node_ver.fetch_add(1, std::memory_order_release);
+
+    // if this leaf node becomes full, do split, remembering the new leaf
+    // pages that now share the leaf's original key range
+    Page<K>* split_lpage = nullptr;
+    Page<K>* split_rpage = nullptr;
+    if (leaf->NumKeys() >= degree) {
+        SplitPage(leaf, path, key);
+        if (leaf->type == PAGE_ROOT) {
+            auto* sroot = reinterpret_cast<PageRoot<K, V>*>(leaf);
+            split_lpage = sroot->children[0];
+            split_rpage = sroot->children[1];
+        } else
+            split_rpage = reinterpret_cast<PageLeaf<K, V>*>(leaf)->next;
+    }
 
     // call concurrency control algorithm's internal node traversal logic on
     // still latched nodes
@@ -415,6 +455,11 @@ void BPTree<K, V>::Put(K key, V value, TxnCxt<K, V>* txn) {
             if (latched_part_begins)
                 txn->ExecWriteTraverseNode(page, page->height);
         }
+
+        // let the transaction follow its own insertion in its node set
+        if (inserted)
+            txn->ExecInsertIntoLeaf(leaf, old_node_ver, split_lpage,
+                                    split_rpage);
     }
 
     // release held page write latch(es)
@@ -423,12 +468,30 @@ void BPTree<K, V>::Put(K key, V value, TxnCxt<K, V>* txn) {
         DEBUG("page latch W release %p", static_cast<void*>(page));
     }
 
+    return record;
+}
+
+template <typename K, typename V>
+void BPTree<K, V>::Put(K key, V value, TxnCxt<K, V>* txn) {
+    DEBUG("req Put %s val %s", StreamStr(key).c_str(),
+          StreamStr(value).c_str());
+    if (txn != nullptr) txn->ExecEnterPut();
+
+    // if transaction is already doomed to abort, skip the work
+    if (txn != nullptr && txn->IsDoomed()) {
+        txn->ExecLeavePut();
+        return;
+    }
+
+    Record<K, V>* record = InjectRecord(key, txn);
+
     // if no concurrency control, write now; otherwise call handler
     if (txn == nullptr) {
-        record->latch.lock();
+        record->Lock();
         DEBUG("record latch W acquire %p", static_cast<void*>(record));
-        record->value = value;
-        record->latch.unlock();
+        uint64_t version = Record<K, V>::TidVersion(record->LoadTid());
+        record->InstallValue(std::move(value), version + 1);
+        record->UnlockWithVersion(version + 1);
         DEBUG("record latch W release %p", static_cast<void*>(record));
     } else
         txn->ExecWriteRecord(record, std::move(value));
@@ -436,11 +499,51 @@ void BPTree<K, V>::Put(K key, V value, TxnCxt<K, V>* txn) {
     if (txn != nullptr) txn->ExecLeavePut();
 }
 
+template <typename K, typename V>
+void BPTree<K, V>::Update(const K& key,
+                          const typename TxnCxt<K, V>::UpdateFn& fn,
+                          TxnCxt<K, V>* txn, bool merge) {
+    DEBUG("req Update %s", StreamStr(key).c_str());
+    if (txn != nullptr) txn->ExecEnterPut();
+
+    // if transaction is already doomed to abort, skip the work
+    if (txn != nullptr && txn->IsDoomed()) {
+        txn->ExecLeavePut();
+        return;
+    }
+
+    Record<K, V>* record = InjectRecord(key, txn);
+
+    // if no concurrency control, read-modify-write under the record latch;
+    // otherwise call handler
+    if (txn == nullptr) {
+        record->Lock();
+        DEBUG("record latch W acquire %p", static_cast<void*>(record));
+        V value;
+        bool found = record->ReadLocked(value);
+        uint64_t version = Record<K, V>::TidVersion(record->LoadTid());
+        record->InstallValue(fn(value, found), version + 1);
+        record->UnlockWithVersion(version + 1);
+        DEBUG("record latch W release %p", static_cast<void*>(record));
+    } else if (merge)
+        txn->ExecMergeRecord(record, fn);
+    else
+        txn->ExecUpdateRecord(record, fn);
+
+    if (txn != nullptr) txn->ExecLeavePut();
+}
+
 template <typename K, typename V>
 bool BPTree<K, V>::Get(const K& key, V& value, TxnCxt<K, V>* txn) {
     DEBUG("req Get %s", StreamStr(key).c_str());
     if (txn != nullptr) txn->ExecEnterGet();
 
+    // if transaction is already doomed to abort, skip the work
+    if (txn != nullptr && txn->IsDoomed()) {
+        txn->ExecLeaveGet();
+        return false;
+    }
+
     // traverse to the correct leaf node and read
     std::vector<Page<K>*> path;
     std::tie(path, std::ignore) = TraverseToLeaf(key, LATCH_READ, txn);
@@ -450,8 +553,9 @@ bool BPTree<K, V>::Get(const K& key, V& value, TxnCxt<K, V>* txn) {
     // search in leaf node for key
     ssize_t idx = leaf->SearchKey(key);
     if (idx == -1 || leaf->keys[idx] != key) {
-        // not found; release held read latch
-        // current concurrency control DOES NOT prevent phantoms
+        // not found; remember the leaf's node version for detecting a
+        // phantom insertion of key, then release held read latch
+        if (txn != nullptr) txn->ExecObserveLeaf(leaf);
         leaf->latch.unlock_shared();
         DEBUG("page latch R release %p", static_cast<void*>(leaf));
         if (txn != nullptr) txn->ExecLeaveGet();
@@ -465,6 +569,7 @@ bool BPTree<K, V>::Get(const K& key, V& value, TxnCxt<K, V>* txn) {
     else
         record = reinterpret_cast<PageLeaf<K, V>*>(leaf)->records[idx];
     assert(record != nullptr);
+    PinIfPhantom(record, txn);
 
     // call concurrency control algorithm's internal node traversal logic on
     // still latched leaf node
@@ -477,13 +582,8 @@ bool BPTree<K, V>::Get(const K& key, V& value, TxnCxt<K, V>* txn) {
     // fetch value in record; if has concurrency control, use the algorithm's
     // read protocol
     if (txn == nullptr) {
-        record->latch.lock_shared();
-        DEBUG("record latch R acquire %p", static_cast<void*>(record));
-        value = record->value;
-        record->latch.unlock_shared();
-        DEBUG("record latch R release %p", static_cast<void*>(record));
-        if (txn != nullptr) txn->ExecLeaveGet();
-        return true;
+        uint64_t tid = record->ReadConsistent(value);
+        return Record<K, V>::TidValid(tid);
     } else {
         if (txn != nullptr) txn->ExecLeaveGet();
         return txn->ExecReadRecord(record, value);
@@ -508,15 +608,29 @@ size_t BPTree<K, V>::Scan(const K& lkey, const K& rkey,
     if (lkey > rkey) return 0;
     if (txn != nullptr) txn->ExecEnterScan();
 
-    // traverse to leaf node for left bound of range
+    // if transaction is already doomed to abort, skip the work
+    if (txn != nullptr && txn->IsDoomed()) {
+        txn->ExecLeaveScan();
+        return 0;
+    }
+
+    // traverse to leaf node for left bound of range, remembering the highkey
+    // of its parent for detecting subtree crossings
     std::vector<Page<K>*> lpath;
-    std::tie(lpath, std::ignore) = TraverseToLeaf(lkey, LATCH_READ, txn);
+    std::optional<K> parent_highkey;
+    std::tie(lpath, std::ignore) =
+        TraverseToLeaf(lkey, LATCH_READ, txn, &parent_highkey);
     assert(lpath.size() > 0);
     Page<K>* lleaf = lpath.back();
+    K from_key = lkey;
 
     // call concurrency control algorithm's internal node traversal logic on
-    // still latched leaf node
-    if (txn != nullptr) txn->ExecReadTraverseNode(lleaf);
+    // still latched leaf node, and remember its node version for detecting
+    // phantom insertions into range
+    if (txn != nullptr) {
+        txn->ExecReadTraverseNode(lleaf);
+        txn->ExecObserveLeaf(lleaf);
+    }
 
     // read out the leaf pages in a loop by following sibling chains,
     // gathering records in range
@@ -535,8 +649,8 @@ size_t BPTree<K, V>::Scan(const K& lkey, const K& rkey,
         // do a search if in left or right bound leaf page
         ssize_t lidx = 0, ridx = leaf->NumKeys() - 1;
         if (leaf == lleaf) {
-            ssize_t idx = leaf->SearchKey(lkey);
-            if (idx >= 0 && leaf->keys[idx] == lkey)
+            ssize_t idx = leaf->SearchKey(from_key);
+            if (idx >= 0 && leaf->keys[idx] == from_key)
                 lidx = idx;
             else if (idx == -1)
                 lidx = 0;
@@ -558,18 +672,14 @@ size_t BPTree<K, V>::Scan(const K& lkey, const K& rkey,
             else
                 record = reinterpret_cast<PageLeaf<K, V>*>(leaf)->records[idx];
             assert(record != nullptr);
+            PinIfPhantom(record, txn);
 
             // if has concurrency control, use algorithm's read protocol
-            // current concurrency control DOES NOT prevent phantoms
             V value;
             bool valid = false;
             if (txn == nullptr) {
-                record->latch.lock_shared();
-                DEBUG("record latch R acquire %p", static_cast<void*>(record));
-                value = record->value;
-                record->latch.unlock_shared();
-                DEBUG("record latch R release %p", static_cast<void*>(record));
-                valid = true;
+                uint64_t tid = record->ReadConsistent(value);
+                valid = Record<K, V>::TidValid(tid);
             } else
                 valid = txn->ExecReadRecord(record, value);
 
@@ -578,6 +688,14 @@ size_t BPTree<K, V>::Scan(const K& lkey, const K& rkey,
                     std::make_tuple(leaf->keys[idx], std::move(value)));
                 nrecords++;
             }
+
+            // stop early if this read doomed the transaction
+            if (txn != nullptr && txn->IsDoomed()) {
+                leaf->latch.unlock_shared();
+                DEBUG("page latch R release %p", static_cast<void*>(leaf));
+                txn->ExecLeaveScan();
+                return nrecords;
+            }
         }
 
         // right bound reached, return
@@ -598,39 +716,35 @@ size_t BPTree<K, V>::Scan(const K& lkey, const K& rkey,
                 return nrecords;
             }
 
-            // call concurrency control algorithm's traversal logic on
-            // internal chained nodes if crossing an internal subtree boundary;
-            // such check is done by utilizing the highkey information
+            // if crossing an internal subtree boundary, the new leaf's
+            // ancestors must be given to concurrency control algorithm's
+            // traversal logic; they cannot be latched while holding a leaf
+            // latch, so re-traverse from root for the new leaf's low key
             //
-            // TODO: this currently assumes no on-the-fly insertions; it is
-            // now also not thread-safe because it reads highkey fields without
-            // read-latching
-            if (txn != nullptr && lpath.size() > 2) {
-                auto* this_leaf = reinterpret_cast<PageLeaf<K, V>*>(leaf);
-                auto* itnl_lo =
-                    reinterpret_cast<PageItnl<K, V>*>(lpath[lpath.size() - 2]);
-                auto* itnl_hi = itnl_lo;
-                bool crossing_subtree =
-                    (this_leaf->highkey.has_value() &&
-                     itnl_lo->highkey.has_value() &&
-                     this_leaf->highkey.value() >= itnl_lo->highkey.value());
-                unsigned crossing_height = 2;
-                while (crossing_subtree) {
-                    lpath[lpath.size() - crossing_height] = itnl_hi->next;
-                    if (++crossing_height >= lpath.size()) break;
-                    itnl_lo = itnl_hi;
-                    itnl_hi = reinterpret_cast<PageItnl<K, V>*>(
-                        lpath[lpath.size() - crossing_height]);
-                    crossing_subtree =
-                        (itnl_hi->highkey.has_value() &&
-                         itnl_lo->highkey.value() >= itnl_hi->highkey.value());
-                }
+            // parent_highkey was read under the parent's latch; if the parent
+            // split since, it may be stale, but then the split has given the
+            // parent a new hv_ver, so no record gets skipped wrongly at
+            // validation
+            auto* this_leaf = reinterpret_cast<PageLeaf<K, V>*>(leaf);
+            if (txn != nullptr && parent_highkey.has_value() &&
+                this_leaf->highkey.has_value() &&
+                this_leaf->highkey.value() >= parent_highkey.value()) {
+                from_key = this_leaf->highkey.value();
+                leaf->latch.unlock_shared();
+                DEBUG("page latch R release %p", static_cast<void*>(leaf));
 
-                if (crossing_height > 2) {
-                    size_t beg_idx = lpath.size() - (crossing_height - 1);
-                    for (size_t idx = beg_idx; idx < lpath.size() - 1; ++idx)
-                        txn->ExecReadTraverseNode(lpath[idx]);
-                }
+                // any key inserted into range after releasing leaf lands in
+                // a leaf split from this one, whose node version changes, or
+                // in the next leaf, observed after re-traversal
+                std::tie(lpath, std::ignore) =
+                    TraverseToLeaf(from_key, LATCH_READ, txn, &parent_highkey);
+                assert(lpath.size() > 0);
+                lleaf = lpath.back();
+                leaf = lleaf;
+
+                txn->ExecReadTraverseNode(leaf);
+                txn->ExecObserveLeaf(leaf);
+                continue;
             }
 
             // latch crabbing in leaf chaining as well
@@ -642,8 +756,11 @@ size_t BPTree<K, V>::Scan(const K& lkey, const K& rkey,
             leaf = next;
 
             // call concurrency control algorithm's traversal logic on
-            // pointer-chained leaf
-            if (txn != nullptr) txn->ExecReadTraverseNode(next);
+            // pointer-chained leaf, and remember its node version
+            if (txn != nullptr) {
+                txn->ExecReadTraverseNode(next);
+                txn->ExecObserveLeaf(next);
+            }
         } else {
             leaf->latch.unlock_shared();
             DEBUG("page latch R release %p", static_cast<void*>(leaf));
@@ -653,6 +770,51 @@ size_t BPTree<K, V>::Scan(const K& lkey, const K& rkey,
     }
 }
 
+template <typename K, typename V>
+bool BPTree<K, V>::RemovePhantom(Record<K, V>* record) {
+    // no split can follow, so only the leaf needs to be write latched; any
+    // ancestors still latched by the traversal are simply released
+    std::vector<Page<K>*> path;
+    std::vector<Page<K>*> write_latched_pages;
+    std::tie(path, write_latched_pages) =
+        TraverseToLeaf(record->key, LATCH_WRITE);
+    assert(path.size() > 0);
+    Page<K>* leaf = path.back();
+
+    std::vector<Record<K, V>*>& records =
+        (leaf->type == PAGE_ROOT)
+            ? reinterpret_cast<PageRoot<K, V>*>(leaf)->records
+            : reinterpret_cast<PageLeaf<K, V>*>(leaf)->records;
+
+    // pins are only taken under the leaf latch, so nobody can get hold of
+    // the record anymore once found unpinned here; someone else may have
+    // removed it already, though, or filled it in since
+    bool removed = false;
+    ssize_t idx = leaf->SearchKey(record->key);
+    if (idx >= 0 && leaf->keys[idx] == record->key && records[idx] == record &&
+        !record->Pinned() && !Record<K, V>::TidValid(record->LoadTid()) &&
+        (leaf->type == PAGE_ROOT || leaf->NumKeys() > 1)) {
+        leaf->keys.erase(leaf->keys.begin() + idx);
+        records.erase(records.begin() + idx);
+
+        // the visible key set is unchanged, but the leaf is, so make those
+        // who observed it re-check
+        leaf->node_ver.fetch_add(1, std::memory_order_release);
+        removed = true;
+    }
+
+    for (auto* page : write_latched_pages) {
+        page->latch.unlock();
+        DEBUG("page latch W release %p", static_cast<void*>(page));
+    }
+
+    if (removed) {
+        DEBUG("phantom record removed %p", static_cast<void*>(record));
+        EpochManager::Global().Retire(record);
+    }
+    return removed;
+}
+
 template <typename K, typename V>
 BPTreeStats BPTree<K, V>::GatherStats(bool print_pages) {
     BPTreeStats stats;
@@ -0,0 +1,184 @@
+#include "epoch.hpp"
+
+#include <cassert>
+#include <chrono>
+
+#include <algorithm>
+
+#include "common.hpp"
+
+namespace garner {
+
+thread_local EpochManager::Slot* EpochManager::local_slot = nullptr;
+thread_local EpochManager::SlotHandle EpochManager::local_handle;
+
+EpochManager& EpochManager::Global() {
+    static EpochManager manager;
+    return manager;
+}
+
+EpochManager::~EpochManager() {
+    if (advancer.joinable()) {
+        advancer.request_stop();
+        advancer.join();
+    }
+
+    // no thread can be reading anymore at static destruction time
+    Slot* slot = slots.load();
+    while (slot != nullptr) {
+        for (auto&& item : slot->retired) item.deleter(item.ptr);
+        Slot* next = slot->next;
+        delete slot;
+        slot = next;
+    }
+}
+
+EpochManager::SlotHandle::~SlotHandle() {
+    if (slot == nullptr) return;
+    // leave any pending retired objects to the next owner of this slot
+    assert(slot->nesting == 0);
+    slot->local_epoch.store(0);
+    slot->in_use.store(false, std::memory_order_release);
+    local_slot = nullptr;
+}
+
+EpochManager::Slot* EpochManager::LocalSlot() {
+    if (local_slot != nullptr) return local_slot;
+
+    // try reusing a slot released by an exited thread
+    Slot* slot = slots.load(std::memory_order_acquire);
+    for (; slot != nullptr; slot = slot->next) {
+        bool expected = false;
+        if (!slot->in_use.load(std::memory_order_relaxed) &&
+            slot->in_use.compare_exchange_strong(expected, true))
+            break;
+    }
+
+    // otherwise allocate a new one and push it to registry list
+    if (slot == nullptr) {
+        uint64_t index = nslots++;
+        if (index >= MAX_WORKERS)
+            throw GarnerException("too many concurrent worker threads");
+        slot = new Slot(index);
+        if (slot == nullptr)
+            throw GarnerException("failed to allocate epoch slot");
+        Slot* head = slots.load();
+        do {
+            slot->next = head;
+        } while (!slots.compare_exchange_weak(head, slot));
+    }
+
+    local_slot = slot;
+    local_handle.slot = slot;
+    return slot;
+}
+
+void EpochManager::Enter() {
+    Slot* slot = LocalSlot();
+    if (slot->nesting++ > 0) return;
+    // seq_cst store so that the announcement is visible before any
+    // subsequent shared pointer load
+    slot->local_epoch.store(global_epoch.load());
+}
+
+void EpochManager::Exit() {
+    Slot* slot = local_slot;
+    assert(slot != nullptr && slot->nesting > 0);
+    if (--slot->nesting > 0) return;
+    slot->local_epoch.store(0, std::memory_order_release);
+}
+
+bool EpochManager::TryAdvance() {
+    uint64_t epoch = global_epoch.load();
+    for (Slot* slot = slots.load(); slot != nullptr; slot = slot->next) {
+        uint64_t local = slot->local_epoch.load();
+        if (local != 0 && local != epoch) return false;
+    }
+    return global_epoch.compare_exchange_strong(epoch, epoch + 1);
+}
+
+void EpochManager::AdvancerLoop(std::stop_token stop_token) {
+    std::unique_lock<std::mutex> lock(advancer_mtx);
+    while (!stop_token.stop_requested()) {
+        advancer_cv.wait_for(lock, stop_token,
+                             std::chrono::milliseconds(EPOCH_PERIOD_MS),
+                             [] { return false; });
+        if (stop_token.stop_requested()) break;
+
+        // critical sections are short, so a straggler holding back the
+        // epoch should leave soon; retry shortly until advanced
+        while (!TryAdvance()) {
+            advancer_cv.wait_for(lock, stop_token,
+                                 std::chrono::microseconds(100),
+                                 [] { return false; });
+            if (stop_token.stop_requested()) return;
+        }
+    }
+}
+
+void EpochManager::StartAdvancer() {
+    std::lock_guard<std::mutex> lock(advancer_mtx);
+    if (advancer_refs++ > 0) return;
+
+    assert(!advancer.joinable());
+    advancer = std::jthread(
+        [this](std::stop_token stop_token) { AdvancerLoop(stop_token); });
+    advancer_running = true;
+}
+
+void EpochManager::StopAdvancer() {
+    std::jthread stopped;
+    {
+        std::lock_guard<std::mutex> lock(advancer_mtx);
+        assert(advancer_refs > 0);
+        if (--advancer_refs > 0) return;
+
+        advancer_running = false;
+        stopped = std::move(advancer);
+    }
+    // destructor of jthread calls request_stop() and join(); must be done
+    // without holding advancer_mtx, which the advancer needs to wake up
+}
+
+uint64_t EpochManager::NewCommitTid() {
+    Slot* slot = LocalSlot();
+
+    // either the first TID of current epoch, or the next sequence number
+    // after this worker's last TID, whichever is larger
+    uint64_t epoch = global_epoch.load();
+    uint64_t epoch_base = (epoch << (TID_SEQ_BITS + TID_WORKER_BITS)) |
+                          slot->index;
+    uint64_t next_seq = slot->last_tid + (1UL << TID_WORKER_BITS);
+    uint64_t tid = std::max(epoch_base, next_seq);
+
+    slot->last_tid = tid;
+    return tid;
+}
+
+void EpochManager::Collect(Slot* slot) {
+    // objects retired at epoch e are safe once global epoch reaches e + 2
+    uint64_t epoch = global_epoch.load();
+    size_t nfreed = 0;
+    while (nfreed < slot->retired.size() &&
+           slot->retired[nfreed].epoch + 2 <= epoch) {
+        slot->retired[nfreed].deleter(slot->retired[nfreed].ptr);
+        nfreed++;
+    }
+    slot->retired.erase(slot->retired.begin(),
+                        slot->retired.begin() + nfreed);
+}
+
+void EpochManager::Retire(void* ptr, void (*deleter)(void*)) {
+    Slot* slot = LocalSlot();
+    slot->retired.push_back(
+        Retired{.ptr = ptr, .deleter = deleter, .epoch = global_epoch.load()});
+
+    if (++slot->nretired_since >= RETIRE_BATCH) {
+        slot->nretired_since = 0;
+        // drive the epoch forward ourselves if no advancer is running
+        if (!advancer_running.load(std::memory_order_relaxed)) TryAdvance();
+        Collect(slot);
+    }
+}
+
+}  // namespace garner
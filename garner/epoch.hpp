@@ -0,0 +1,234 @@
+// Epoch -- global epochs for commit TIDs and memory reclamation.
+
+#include <algorithm>
+#include <atomic>
+#include <condition_variable>
+#include <cstdint>
+#include <mutex>
+#include <stop_token>
+#include <thread>
+#include <vector>
+
+#pragma once
+
+namespace garner {
+
+/**
+ * Global epoch manager, as in Silo.
+ * https://dl.acm.org/doi/10.1145/2517349.2522713
+ *
+ * The global epoch is advanced periodically by a background thread (every
+ * EPOCH_PERIOD_MS). It serves two purposes:
+ *
+ * Commit TIDs: a committing transaction reads the epoch at its serialization
+ * point and combines it with a worker-local sequence number and the worker
+ * ID. This takes constant time regardless of transaction size. TIDs are
+ * unique, increase per worker, and are ordered across epochs; they are not
+ * necessarily ordered within an epoch across workers, which is fine since
+ * validation only compares versions for equality.
+ *
+ * Memory reclamation (EBR): readers that dereference shared pointers without
+ * holding a latch (e.g., record values read seqlock-style) do so inside an
+ * epoch critical section. Writers that unlink such an object retire it
+ * instead of deleting it; the object is freed only after the global epoch
+ * has advanced twice since its retirement, at which point no reader can
+ * still be holding it.
+ *
+ * Each thread owns one participant slot, registered lazily on first use and
+ * handed back for reuse when the thread exits. The slot index doubles as the
+ * worker ID in TIDs.
+ */
+class EpochManager {
+   private:
+    /** An object waiting for reclamation. */
+    struct Retired {
+        void* ptr;
+        void (*deleter)(void*);
+        uint64_t epoch;
+    };
+
+    /** Per-thread participant slot, on its own cache line. */
+    struct alignas(64) Slot {
+        // epoch announced while inside a critical section, 0 if outside
+        std::atomic<uint64_t> local_epoch;
+
+        // true if currently owned by a live thread
+        std::atomic<bool> in_use;
+
+        // next slot in registry list; slots are never unlinked
+        Slot* next;
+
+        // unique index of slot, used as worker ID in TIDs
+        const uint64_t index;
+
+        // last commit TID generated by owner, only accessed by owner
+        uint64_t last_tid;
+
+        // critical section nesting depth, only accessed by owner
+        unsigned nesting;
+
+        // retired objects not yet freed in epoch order, and number of
+        // retirements since last collection, only accessed by owner
+        std::vector<Retired> retired;
+        size_t nretired_since;
+
+        Slot(uint64_t index)
+            : local_epoch(0),
+              in_use(true),
+              next(nullptr),
+              index(index),
+              last_tid(0),
+              nesting(0),
+              retired(),
+              nretired_since(0) {}
+    };
+
+    /** Releases the owning thread's slot at thread exit. */
+    struct SlotHandle {
+        Slot* slot = nullptr;
+        ~SlotHandle();
+    };
+
+    // number of retirements between two reclamation attempts
+    static constexpr size_t RETIRE_BATCH = 64;
+
+    // global epoch number, starts from 1 (0 means quiescent)
+    std::atomic<uint64_t> global_epoch;
+
+    // head of registry list of all slots, and number of slots allocated
+    std::atomic<Slot*> slots;
+    std::atomic<uint64_t> nslots;
+
+    // background epoch advancer thread, shared by all users through a
+    // reference count
+    std::mutex advancer_mtx;
+    std::condition_variable_any advancer_cv;
+    unsigned advancer_refs;
+    std::jthread advancer;
+    std::atomic<bool> advancer_running;
+
+    // slot of the calling thread, nullptr if not registered yet
+    static thread_local Slot* local_slot;
+    static thread_local SlotHandle local_handle;
+
+    EpochManager()
+        : global_epoch(1),
+          slots(nullptr),
+          nslots(0),
+          advancer_mtx(),
+          advancer_cv(),
+          advancer_refs(0),
+          advancer(),
+          advancer_running(false) {}
+
+    /**
+     * Get the calling thread's slot, registering one if necessary.
+     */
+    Slot* LocalSlot();
+
+    /**
+     * Free retired objects of given slot that are safe to reclaim.
+     */
+    void Collect(Slot* slot);
+
+    /**
+     * Body of background epoch advancer thread.
+     */
+    void AdvancerLoop(std::stop_token stop_token);
+
+   public:
+    // period of epoch advancement by the background thread
+    static constexpr unsigned EPOCH_PERIOD_MS = 40;
+
+    // TID layout within the 62 version bits of a record TID word:
+    // [ epoch : 32 ][ worker sequence : 20 ][ worker ID : 10 ]
+    static constexpr unsigned TID_WORKER_BITS = 10;
+    static constexpr unsigned TID_SEQ_BITS = 20;
+    static constexpr uint64_t MAX_WORKERS = 1UL << TID_WORKER_BITS;
+
+    EpochManager(const EpochManager&) = delete;
+    EpochManager& operator=(const EpochManager&) = delete;
+
+    ~EpochManager();
+
+    /**
+     * The process-wide manager instance.
+     */
+    static EpochManager& Global();
+
+    /**
+     * Current global epoch number.
+     */
+    uint64_t CurrEpoch() const {
+        return global_epoch.load(std::memory_order_acquire);
+    }
+
+    /**
+     * Epoch to read a fresh snapshot at: versions committed in epochs before
+     * it are all in place already. Never 0, which callers may reserve for
+     * not picked.
+     */
+    uint64_t SnapshotEpoch() const {
+        // global epoch starts from 1, so the unclamped value is at least 0,
+        // at which nothing would be visible anyway
+        return std::max(CurrEpoch() - 1, uint64_t(1));
+    }
+
+    /**
+     * Enter/exit a critical section on the calling thread. May be nested.
+     */
+    void Enter();
+    void Exit();
+
+    /**
+     * Try to advance the global epoch by one. Succeeds only if every thread
+     * currently inside a critical section has observed the current epoch.
+     * Returns true if advanced.
+     */
+    bool TryAdvance();
+
+    /**
+     * Start/stop the background epoch advancer. Calls are reference counted,
+     * so each Garner instance can hold it while alive.
+     */
+    void StartAdvancer();
+    void StopAdvancer();
+
+    /**
+     * Generate a fresh commit TID for the calling worker thread, in constant
+     * time. Should be called at the serialization point of commit.
+     */
+    uint64_t NewCommitTid();
+
+    /**
+     * Extract the epoch number out of a commit TID.
+     */
+    static uint64_t TidEpoch(uint64_t tid) {
+        return tid >> (TID_SEQ_BITS + TID_WORKER_BITS);
+    }
+
+    /**
+     * Retire an unlinked object, deleting it once no reader can hold it.
+     */
+    void Retire(void* ptr, void (*deleter)(void*));
+
+    template <typename T>
+    void Retire(T* ptr) {
+        Retire(static_cast<void*>(ptr),
+               [](void* p) { delete static_cast<T*>(p); });
+    }
+};
+
+/**
+ * RAII helper for an epoch critical section.
+ */
+class EpochGuard {
+   public:
+    EpochGuard() { EpochManager::Global().Enter(); }
+    ~EpochGuard() { EpochManager::Global().Exit(); }
+
+    EpochGuard(const EpochGuard&) = delete;
+    EpochGuard& operator=(const EpochGuard&) = delete;
+};
+
+}  // namespace garner
@@ -1,17 +1,32 @@
 // GarnerImpl -- internal implementation of Garner DB interface struct.
 
+#include <algorithm>
 #include <atomic>
+#include <chrono>
+#include <functional>
+#include <mutex>
+#include <random>
 #include <string>
+#include <thread>
+#include <tuple>
 #include <vector>
 
+#include "batch.hpp"
 #include "bptree.hpp"
 #include "build_options.hpp"
 #include "common.hpp"
+#include "epoch.hpp"
 #include "include/garner.hpp"
 #include "page.hpp"
+#include "scheduler.hpp"
 #include "txn.hpp"
+#include "txn_2pl.hpp"
+#include "txn_autocommit.hpp"
+#include "txn_readonly.hpp"
 #include "txn_silo.hpp"
 #include "txn_silo_hv.hpp"
+#include "txn_snapshot.hpp"
+#include "txn_tictoc.hpp"
 
 #pragma once
 
@@ -28,22 +43,174 @@ class GarnerImpl : public Garner {
     // type of transaction OCC protocol to use
     TxnProtocol protocol;
 
+    // max height of pages tracked by hierarchical validation, 0 means all
+    unsigned hv_max_height;
+
+    // true if asked to lock hot records at access time
+    bool hot_locking;
+
+    // held by the RunTxn caller currently in pessimistic fallback mode; other
+    // RunTxn callers hold off starting and committing while the flag is set
+    std::mutex fallback_mtx;
+    std::atomic<bool> fallback_active;
+
+    // transaction scheduler for SubmitTxn, nullptr if not enabled
+    TxnScheduler* scheduler;
+
+    /**
+     * Configuration a transaction context is created with. Contexts may only
+     * be recycled among instances of identical kind.
+     */
+    struct TxnCxtKind {
+        TxnProtocol protocol;
+        bool autocommit;
+        TxnMode mode;
+        TxnIsolation isolation;
+        unsigned hv_max_height;
+        bool hot_locking;
+
+        bool operator==(const TxnCxtKind&) const = default;
+    };
+
+    TxnCxtKind CxtKind(bool autocommit, TxnMode mode = TXN_READ_WRITE,
+                       TxnIsolation isolation = ISOLATION_SERIALIZABLE) const {
+        return TxnCxtKind{.protocol = protocol,
+                          .autocommit = autocommit,
+                          .mode = mode,
+                          .isolation = isolation,
+                          .hv_max_height = hv_max_height,
+                          .hot_locking = HotLocking()};
+    }
+
+    /**
+     * Per-thread pool of idle transaction contexts. Finished contexts are
+     * reset and kept here, so that short transactions reuse their container
+     * capacity instead of going through malloc/free every time.
+     */
+    struct TxnCxtPool {
+        // max number of idle contexts kept per thread
+        static constexpr size_t MAX_IDLE = 8;
+
+        // (context kind, context pointer)
+        std::vector<std::pair<TxnCxtKind, TxnCxt<KType, VType>*>> idle;
+
+        TxnCxtPool() : idle() { idle.reserve(MAX_IDLE); }
+        ~TxnCxtPool();
+
+        /**
+         * Take an idle context of given kind, or nullptr if none.
+         */
+        TxnCxt<KType, VType>* Acquire(const TxnCxtKind& kind);
+
+        /**
+         * Give back a finished context. Returns false if the pool is full,
+         * in which case the caller should delete it.
+         */
+        bool Release(const TxnCxtKind& kind, TxnCxt<KType, VType>* txn);
+    };
+
+    static thread_local TxnCxtPool txn_pool;
+
+    /**
+     * Returns true if asked to and the configured protocol locks hot records
+     * at access time; the validation-free roofline never aborts, so it has
+     * none.
+     */
+    bool HotLocking() const {
+        return hot_locking &&
+               (protocol == PROTOCOL_SILO || protocol == PROTOCOL_SILO_HV ||
+                protocol == PROTOCOL_SILO_AD);
+    }
+
+    /**
+     * Returns the isolation level a transaction of given access mode asking
+     * for given level actually runs at under the configured protocol.
+     */
+    TxnIsolation EffectiveIsolation(TxnMode mode,
+                                    TxnIsolation isolation) const {
+        bool is_silo = protocol == PROTOCOL_SILO ||
+                       protocol == PROTOCOL_SILO_HV ||
+                       protocol == PROTOCOL_SILO_NR ||
+                       protocol == PROTOCOL_SILO_AD;
+        if (!is_silo || mode != TXN_READ_WRITE) return ISOLATION_SERIALIZABLE;
+        return isolation;
+    }
+
+    /**
+     * Allocate a brand new transaction context of the configured protocol.
+     * If autocommit is true, allocate a lightweight single-op context;
+     * otherwise allocate one for the given access mode and effective
+     * isolation level.
+     */
+    TxnCxt<KType, VType>* NewTxnCxt(
+        bool autocommit, TxnMode mode = TXN_READ_WRITE,
+        TxnIsolation isolation = ISOLATION_SERIALIZABLE);
+
+    /**
+     * Start/finish an implicit single-op transaction for a point Get or a
+     * blind Put, bypassing read set tracking and validation.
+     */
+    TxnCxt<KType, VType>* StartAutocommitTxn();
+    bool FinishAutocommitTxn(TxnCxt<KType, VType>* txn);
+
+    /**
+     * Discard a transaction context without committing it.
+     */
+    void DiscardTxn(TxnCxt<KType, VType>* txn);
+
+    /**
+     * Drop the pins a finished transaction held on phantom records, removing
+     * from the tree those it was the last to unpin and that remain phantoms,
+     * e.g. inserted by an aborted transaction.
+     */
+    void UnpinPhantoms(std::vector<Record<KType, VType>*>& records);
+
+    /**
+     * Spin until no RunTxn caller is in pessimistic fallback mode.
+     */
+    void WaitForFallback() const;
+
+    /**
+     * Sleep for a jittered exponential backoff after the given number of
+     * aborts.
+     */
+    static void Backoff(const RetryPolicy& policy, unsigned naborts);
+
    public:
-    GarnerImpl(size_t degree, TxnProtocol protocol);
+    GarnerImpl(size_t degree, TxnProtocol protocol, unsigned hv_max_height,
+               unsigned sched_workers, unsigned hv_stripe_height,
+               bool hot_locking);
 
     GarnerImpl(const GarnerImpl&) = delete;
     GarnerImpl& operator=(const GarnerImpl&) = delete;
 
     ~GarnerImpl();
 
-    TxnCxt<KType, VType>* StartTxn() override;
+    TxnCxt<KType, VType>* StartTxn(
+        TxnMode mode = TXN_READ_WRITE,
+        TxnIsolation isolation = ISOLATION_SERIALIZABLE) override;
     bool FinishTxn(TxnCxt<KType, VType>* txn,
                    std::atomic<uint64_t>* ser_counter = nullptr,
                    uint64_t* ser_order = nullptr,
                    struct TxnStats* stats = nullptr) override;
+    bool TxnDoomed(const TxnCxt<KType, VType>* txn) const override;
+    bool RunTxn(std::function<void(TxnCxt<KType, VType>*)> body,
+                const RetryPolicy& policy = RetryPolicy(),
+                unsigned* nretries = nullptr) override;
+    std::future<bool> SubmitTxn(
+        std::function<void(TxnCxt<KType, VType>*)> body,
+        const std::vector<KType>& keys,
+        const RetryPolicy& policy = RetryPolicy()) override;
+    void RunBatch(const std::vector<BatchTxn>& batch,
+                  unsigned nworkers) override;
 
     bool Put(KType key, VType value,
              TxnCxt<KType, VType>* txn = nullptr) override;
+    bool Update(const KType& key, std::function<VType(const VType&, bool)> fn,
+                TxnCxt<KType, VType>* txn = nullptr) override;
+    bool Merge(const KType& key, VType delta,
+               std::function<VType(const VType&, bool, const VType&)> merge_fn,
+               TxnCxt<KType, VType>* txn = nullptr) override;
     bool Get(const KType& key, VType& value, bool& found,
              TxnCxt<KType, VType>* txn = nullptr) override;
     bool Delete(const KType& key, bool& found,
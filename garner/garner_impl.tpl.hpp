@@ -4,29 +4,130 @@
 
 namespace garner {
 
-GarnerImpl::GarnerImpl(size_t degree, TxnProtocol protocol)
-    : protocol(protocol) {
-    bptree = new BPTree<KType, VType>(degree);
+GarnerImpl::GarnerImpl(size_t degree, TxnProtocol protocol,
+                       unsigned hv_max_height, unsigned sched_workers,
+                       unsigned hv_stripe_height, bool hot_locking)
+    : protocol(protocol),
+      hv_max_height(hv_max_height),
+      hot_locking(hot_locking),
+      fallback_mtx(),
+      fallback_active(false),
+      scheduler(nullptr) {
+    // only hierarchical validation protocols ever touch hv_sem
+    if (protocol != PROTOCOL_SILO_HV && protocol != PROTOCOL_SILO_NR &&
+        protocol != PROTOCOL_SILO_AD)
+        hv_stripe_height = 0;
+    bptree = new BPTree<KType, VType>(degree, hv_stripe_height);
     if (bptree == nullptr)
         throw GarnerException("failed to allocate BPtree instance");
+
+    // OCC protocols draw commit TIDs from the global epoch
+    if (protocol != PROTOCOL_NONE) EpochManager::Global().StartAdvancer();
+
+    if (sched_workers > 0) {
+        scheduler = new TxnScheduler(this, sched_workers);
+        if (scheduler == nullptr)
+            throw GarnerException("failed to allocate TxnScheduler instance");
+    }
 }
 
-GarnerImpl::~GarnerImpl() { delete bptree; }
+GarnerImpl::~GarnerImpl() {
+    // finishes all submitted transactions
+    delete scheduler;
+    if (protocol != PROTOCOL_NONE) EpochManager::Global().StopAdvancer();
+    delete bptree;
+}
 
-TxnCxt<Garner::KType, Garner::VType>* GarnerImpl::StartTxn() {
-    // allocate new TxnCxt struct
+thread_local GarnerImpl::TxnCxtPool GarnerImpl::txn_pool;
+
+GarnerImpl::TxnCxtPool::~TxnCxtPool() {
+    for (auto&& [_, txn] : idle) delete txn;
+}
+
+TxnCxt<Garner::KType, Garner::VType>* GarnerImpl::TxnCxtPool::Acquire(
+    const TxnCxtKind& kind) {
+    // search from the back, most recently released context first
+    for (auto it = idle.rbegin(); it != idle.rend(); ++it) {
+        if (it->first == kind) {
+            TxnCxt<KType, VType>* txn = it->second;
+            idle.erase(std::next(it).base());
+            return txn;
+        }
+    }
+    return nullptr;
+}
+
+bool GarnerImpl::TxnCxtPool::Release(const TxnCxtKind& kind,
+                                     TxnCxt<KType, VType>* txn) {
+    if (idle.size() >= MAX_IDLE) return false;
+    txn->Reset();
+    idle.emplace_back(kind, txn);
+    return true;
+}
+
+TxnCxt<Garner::KType, Garner::VType>* GarnerImpl::NewTxnCxt(
+    bool autocommit, TxnMode mode, TxnIsolation isolation) {
     TxnCxt<KType, VType>* txn = nullptr;
+    if (autocommit) {
+        // HV variants must keep page hv_ver up-to-date for writes, 2PL
+        // variants must not be written past, and TicToc must keep record
+        // timestamps up-to-date; hot record locks are advisory, as their
+        // holders still validate, so they are not waited on
+        bool is_hv = protocol == PROTOCOL_SILO_HV ||
+                     protocol == PROTOCOL_SILO_NR ||
+                     protocol == PROTOCOL_SILO_AD;
+        bool is_2pl = protocol == PROTOCOL_2PL_NOWAIT ||
+                      protocol == PROTOCOL_2PL_WAITDIE;
+        bool is_tictoc = protocol == PROTOCOL_TICTOC;
+        txn = new TxnAutocommit<KType, VType>(is_hv, hv_max_height, is_2pl,
+                                              is_tictoc);
+        if (txn == nullptr)
+            throw GarnerException("failed to allocate transaction context");
+        return txn;
+    }
+    if (protocol == PROTOCOL_TICTOC) {
+        // OCC read-only and snapshot reads assume commit order matches TID
+        // order, so TicToc validates those the TicToc way as well
+        txn = new TxnTicToc<KType, VType>(mode);
+        if (txn == nullptr)
+            throw GarnerException("failed to allocate transaction context");
+        return txn;
+    }
+    if (mode == TXN_READ_ONLY) {
+        // same for all protocols, except for the validation-free roofline
+        txn = new TxnReadOnly<KType, VType>(protocol == PROTOCOL_SILO_NR);
+        if (txn == nullptr)
+            throw GarnerException("failed to allocate transaction context");
+        return txn;
+    }
+    if (mode == TXN_SNAPSHOT) {
+        txn = new TxnSnapshot<KType, VType>();
+        if (txn == nullptr)
+            throw GarnerException("failed to allocate transaction context");
+        return txn;
+    }
+
     switch (protocol) {
-        case PROTOCOL_NONE:
-            return nullptr;
         case PROTOCOL_SILO:
-            txn = new TxnSilo<KType, VType>();
+            txn = new TxnSilo<KType, VType>(HotLocking(), isolation);
             break;
         case PROTOCOL_SILO_HV:
-            txn = new TxnSiloHV<KType, VType>();
+            txn = new TxnSiloHV<KType, VType>(false, hv_max_height, false,
+                                              HotLocking(), isolation);
             break;
         case PROTOCOL_SILO_NR:
-            txn = new TxnSiloHV<KType, VType>(true);
+            txn = new TxnSiloHV<KType, VType>(true, hv_max_height, false,
+                                              false, isolation);
+            break;
+        case PROTOCOL_SILO_AD:
+            txn = new TxnSiloHV<KType, VType>(false, hv_max_height, true,
+                                              HotLocking(), isolation);
+            break;
+        case PROTOCOL_2PL_NOWAIT:
+            txn = new Txn2PL<KType, VType>(false);
+            break;
+        case PROTOCOL_2PL_WAITDIE:
+            txn = new Txn2PL<KType, VType>(true);
             break;
         default:
             throw GarnerException("unknown transaction protocol type");
@@ -34,6 +135,20 @@ TxnCxt<Garner::KType, Garner::VType>* GarnerImpl::StartTxn() {
 
     if (txn == nullptr)
         throw GarnerException("failed to allocate transaction context");
+    return txn;
+}
+
+TxnCxt<Garner::KType, Garner::VType>* GarnerImpl::StartTxn(
+    TxnMode mode, TxnIsolation isolation) {
+    if (protocol == PROTOCOL_NONE) return nullptr;
+    isolation = EffectiveIsolation(mode, isolation);
+
+    // recycle an idle context of this thread if possible, otherwise
+    // allocate new TxnCxt struct
+    TxnCxt<KType, VType>* txn =
+        txn_pool.Acquire(CxtKind(false, mode, isolation));
+    if (txn == nullptr) txn = NewTxnCxt(false, mode, isolation);
+
     DEBUG("txn %p starts", static_cast<void*>(txn));
     return txn;
 }
@@ -48,12 +163,169 @@ bool GarnerImpl::FinishTxn(TxnCxt<KType, VType>* txn,
             committed = txn->TryCommit(ser_counter, ser_order);
         else
             committed = txn->TryCommit(ser_counter, ser_order, stats);
-        delete txn;  // deallocate at finish
+        std::vector<Record<KType, VType>*> pinned;
+        txn->TakePinned(pinned);
+        // return to this thread's pool, deallocate if pool is full
+        TxnCxtKind kind = CxtKind(false, txn->Mode(), txn->Isolation());
+        if (!txn_pool.Release(kind, txn)) delete txn;
+        UnpinPhantoms(pinned);
     }
     return committed;
 }
 
+bool GarnerImpl::TxnDoomed(const TxnCxt<KType, VType>* txn) const {
+    return txn != nullptr && txn->IsDoomed();
+}
+
+void GarnerImpl::DiscardTxn(TxnCxt<KType, VType>* txn) {
+    if (txn == nullptr) return;
+    std::vector<Record<KType, VType>*> pinned;
+    txn->TakePinned(pinned);
+    TxnCxtKind kind = CxtKind(false, txn->Mode(), txn->Isolation());
+    if (!txn_pool.Release(kind, txn)) delete txn;
+    UnpinPhantoms(pinned);
+}
+
+void GarnerImpl::UnpinPhantoms(std::vector<Record<KType, VType>*>& records) {
+    if (records.empty()) return;
+    // whoever removes a record retires it, so hold off reclamation of those
+    // still in my hands
+    EpochGuard guard;
+    for (auto* record : records) {
+        if (record->Unpin() == 0 &&
+            !Record<KType, VType>::TidValid(record->LoadTid()))
+            bptree->RemovePhantom(record);
+    }
+}
+
+void GarnerImpl::WaitForFallback() const {
+    while (fallback_active.load(std::memory_order_acquire))
+        std::this_thread::yield();
+}
+
+void GarnerImpl::Backoff(const RetryPolicy& policy, unsigned naborts) {
+    static thread_local std::minstd_rand gen(std::random_device{}());
+
+    assert(naborts > 0);
+    unsigned shift = std::min(naborts - 1, 31U);
+    uint64_t cap =
+        std::min(static_cast<uint64_t>(policy.backoff_max_us),
+                 static_cast<uint64_t>(policy.backoff_base_us) << shift);
+    if (cap == 0) return;
+
+    // full jitter, so that conflicting transactions spread out their retries;
+    // spin-yield rather than sleep since OS sleeps are too coarse here
+    std::uniform_int_distribution<uint64_t> rand_us(0, cap);
+    auto deadline = std::chrono::steady_clock::now() +
+                    std::chrono::microseconds(rand_us(gen));
+    while (std::chrono::steady_clock::now() < deadline)
+        std::this_thread::yield();
+}
+
+bool GarnerImpl::RunTxn(std::function<void(TxnCxt<KType, VType>*)> body,
+                        const RetryPolicy& policy, unsigned* nretries) {
+    if (nretries != nullptr) *nretries = 0;
+
+    // without concurrency control, there is nothing to abort
+    if (protocol == PROTOCOL_NONE) {
+        body(nullptr);
+        return true;
+    }
+
+    std::unique_lock<std::mutex> fallback_lock(fallback_mtx, std::defer_lock);
+    unsigned naborts = 0;
+    bool committed = false;
+
+    while (true) {
+        // switch to pessimistic mode after too many aborts: once holding the
+        // fallback lock, no other RunTxn caller starts or commits, so we can
+        // only be aborted by transactions already past that point or not run
+        // through RunTxn
+        if (!fallback_lock.owns_lock() && policy.fallback_after > 0 &&
+            naborts >= policy.fallback_after) {
+            fallback_lock.lock();
+            fallback_active.store(true, std::memory_order_release);
+        }
+        if (!fallback_lock.owns_lock()) WaitForFallback();
+
+        TxnCxt<KType, VType>* txn = StartTxn();
+        try {
+            body(txn);
+        } catch (...) {
+            DiscardTxn(txn);
+            if (fallback_lock.owns_lock())
+                fallback_active.store(false, std::memory_order_release);
+            throw;
+        }
+
+        // the fallback transaction may be waiting on record locks my body
+        // took, so never wait for it while holding them: discard and re-run
+        // the body once it is done, which does not count as an abort
+        if (!fallback_lock.owns_lock() &&
+            fallback_active.load(std::memory_order_acquire)) {
+            DiscardTxn(txn);
+            continue;
+        }
+        committed = FinishTxn(txn);
+        if (committed) break;
+
+        naborts++;
+        if (policy.max_retries > 0 && naborts > policy.max_retries) break;
+        Backoff(policy, naborts);
+    }
+
+    if (fallback_lock.owns_lock())
+        fallback_active.store(false, std::memory_order_release);
+
+    if (nretries != nullptr) *nretries = committed ? naborts : naborts - 1;
+    return committed;
+}
+
+std::future<bool> GarnerImpl::SubmitTxn(
+    std::function<void(TxnCxt<KType, VType>*)> body,
+    const std::vector<KType>& keys, const RetryPolicy& policy) {
+    if (scheduler == nullptr)
+        throw GarnerException("transaction scheduler not enabled");
+    return scheduler->Submit(std::move(body), keys, policy);
+}
+
+void GarnerImpl::RunBatch(const std::vector<BatchTxn>& batch,
+                          unsigned nworkers) {
+    // bodies go through the single-op paths, which under OCC protocols
+    // still install writes with commit TIDs, so that concurrent validating
+    // transactions and snapshots see consistent versions
+    TxnBatch txn_batch(batch);
+    txn_batch.Execute(nworkers);
+}
+
+TxnCxt<Garner::KType, Garner::VType>* GarnerImpl::StartAutocommitTxn() {
+    assert(protocol != PROTOCOL_NONE);
+    TxnCxt<KType, VType>* txn = txn_pool.Acquire(CxtKind(true));
+    if (txn == nullptr) txn = NewTxnCxt(true);
+    return txn;
+}
+
+bool GarnerImpl::FinishAutocommitTxn(TxnCxt<KType, VType>* txn) {
+    assert(txn != nullptr);
+    bool committed = txn->TryCommit();
+    std::vector<Record<KType, VType>*> pinned;
+    txn->TakePinned(pinned);
+    if (!txn_pool.Release(CxtKind(true), txn)) delete txn;
+    UnpinPhantoms(pinned);
+    return committed;
+}
+
 bool GarnerImpl::Put(KType key, VType value, TxnCxt<KType, VType>* txn) {
+    if (txn != nullptr && txn->Mode() != TXN_READ_WRITE)
+        throw GarnerException("Put issued in read-only transaction");
+
+    // blind single-key Put: install directly with a new version
+    if (txn == nullptr && protocol != PROTOCOL_NONE) {
+        TxnCxt<KType, VType>* ac_txn = StartAutocommitTxn();
+        bptree->Put(std::move(key), std::move(value), ac_txn);
+        return FinishAutocommitTxn(ac_txn);
+    }
+
     TxnCxt<KType, VType>* this_txn = txn;
     if (txn == nullptr) this_txn = StartTxn();
 
@@ -65,8 +337,57 @@ bool GarnerImpl::Put(KType key, VType value, TxnCxt<KType, VType>* txn) {
         return FinishTxn(this_txn);
 }
 
+bool GarnerImpl::Update(const KType& key,
+                        std::function<VType(const VType&, bool)> fn,
+                        TxnCxt<KType, VType>* txn) {
+    if (txn != nullptr && txn->Mode() != TXN_READ_WRITE)
+        throw GarnerException("Update issued in read-only transaction");
+
+    // not blind, so a single-key Update needs a full transaction
+    TxnCxt<KType, VType>* this_txn = txn;
+    if (txn == nullptr) this_txn = StartTxn();
+
+    bptree->Update(key, fn, this_txn);
+
+    if (txn != nullptr)
+        return false;
+    else
+        return FinishTxn(this_txn);
+}
+
+bool GarnerImpl::Merge(
+    const KType& key, VType delta,
+    std::function<VType(const VType&, bool, const VType&)> merge_fn,
+    TxnCxt<KType, VType>* txn) {
+    if (txn != nullptr && txn->Mode() != TXN_READ_WRITE)
+        throw GarnerException("Merge issued in read-only transaction");
+
+    TxnCxt<KType, VType>* this_txn = txn;
+    if (txn == nullptr) this_txn = StartTxn();
+
+    bptree->Update(
+        key,
+        [delta = std::move(delta), merge_fn = std::move(merge_fn)](
+            const VType& value, bool found) {
+            return merge_fn(value, found, delta);
+        },
+        this_txn, true);
+
+    if (txn != nullptr)
+        return false;
+    else
+        return FinishTxn(this_txn);
+}
+
 bool GarnerImpl::Get(const KType& key, VType& value, bool& found,
                      TxnCxt<KType, VType>* txn) {
+    // single-key Get: one consistent record read, nothing to validate
+    if (txn == nullptr && protocol != PROTOCOL_NONE) {
+        TxnCxt<KType, VType>* ac_txn = StartAutocommitTxn();
+        found = bptree->Get(key, value, ac_txn);
+        return FinishAutocommitTxn(ac_txn);
+    }
+
     TxnCxt<KType, VType>* this_txn = txn;
     if (txn == nullptr) this_txn = StartTxn();
 
@@ -80,6 +401,9 @@ bool GarnerImpl::Get(const KType& key, VType& value, bool& found,
 
 bool GarnerImpl::Delete(const KType& key, bool& found,
                         TxnCxt<KType, VType>* txn) {
+    if (txn != nullptr && txn->Mode() != TXN_READ_WRITE)
+        throw GarnerException("Delete issued in read-only transaction");
+
     TxnCxt<KType, VType>* this_txn = txn;
     if (txn == nullptr) this_txn = StartTxn();
 
@@ -0,0 +1,92 @@
+// HotLocks -- pessimistic locks on hot records held by an OCC transaction.
+
+#include <algorithm>
+#include <cstdint>
+#include <iostream>
+#include <thread>
+#include <vector>
+
+#include "common.hpp"
+#include "record.hpp"
+
+#pragma once
+
+namespace garner {
+
+/**
+ * Set of hot records locked at access time by an otherwise optimistic
+ * transaction, as in MOCC.
+ *
+ * Hot records are locked exclusively through the record's 2PL lock word
+ * and held until the transaction finishes; since hot records are mostly
+ * read-modify-written, taking the lock shared would only move the conflict
+ * to the upgrade. Committing transactions refuse to install a record that
+ * someone else holds locked, so a read under the lock usually stays valid.
+ * The locks are advisory all the same: autocommit writes never wait on
+ * them, and holders still validate their reads.
+ *
+ * To stay deadlock-free, a lock is only waited for if it comes after all
+ * held ones in address order and the caller holds no page latch; otherwise
+ * it is tried once, and on failure the record is simply accessed
+ * optimistically. The fallback transaction of RunTxn may wait on hot locks
+ * of any other RunTxn caller, so those never wait for the fallback while
+ * holding hot locks; they discard their transaction first.
+ */
+template <typename K, typename V>
+class HotLocks {
+   private:
+    // records locked, and the largest of them by address
+    std::vector<Record<K, V>*> held;
+    Record<K, V>* max_held = nullptr;
+
+   public:
+    HotLocks() : held(), max_held(nullptr) {}
+
+    HotLocks(const HotLocks&) = delete;
+    HotLocks& operator=(const HotLocks&) = delete;
+
+    ~HotLocks() { ReleaseAll(); }
+
+    /**
+     * Lock record if it is hot and not yet held. may_wait should be false if
+     * the caller holds a page latch.
+     */
+    void LockIfHot(Record<K, V>* record, bool may_wait);
+
+    /**
+     * Returns true if record is locked by me.
+     */
+    bool Holds(Record<K, V>* record) const {
+        return std::find(held.begin(), held.end(), record) != held.end();
+    }
+
+    /**
+     * Returns true if nobody else holds record locked, so that I may install
+     * a write to it. Must hold record's TID word lock.
+     */
+    bool MayInstall(Record<K, V>* record) const {
+        return !record->Locked2PL() || Holds(record);
+    }
+
+    /**
+     * Release all held locks.
+     */
+    void ReleaseAll();
+
+    template <typename KK, typename VV>
+    friend std::ostream& operator<<(std::ostream& s,
+                                    const HotLocks<KK, VV>& locks);
+};
+
+template <typename K, typename V>
+std::ostream& operator<<(std::ostream& s, const HotLocks<K, V>& locks) {
+    s << "HotLocks{held=[";
+    for (auto* record : locks.held) s << record << ",";
+    s << "]}";
+    return s;
+}
+
+}  // namespace garner
+
+// Include template implementation in-place.
+#include "hot_locks.tpl.hpp"
@@ -0,0 +1,35 @@
+// Template implementation included in-place by the ".hpp".
+
+#pragma once
+
+namespace garner {
+
+template <typename K, typename V>
+void HotLocks<K, V>::LockIfHot(Record<K, V>* record, bool may_wait) {
+    if (!record->IsHot() || Holds(record)) return;
+
+    // waiting only in address order rules out cycles among waiters
+    bool in_order = reinterpret_cast<uint64_t>(record) >
+                    reinterpret_cast<uint64_t>(max_held);
+    uint64_t holder_ts;
+    while (!record->TryLock2PL(true, false, 0, holder_ts)) {
+        if (!may_wait || !in_order) return;
+        std::this_thread::yield();
+    }
+    DEBUG("record hot lock acquire %p", static_cast<void*>(record));
+
+    held.push_back(record);
+    if (in_order) max_held = record;
+}
+
+template <typename K, typename V>
+void HotLocks<K, V>::ReleaseAll() {
+    for (auto* record : held) {
+        record->Unlock2PL(true);
+        DEBUG("record hot lock release %p", static_cast<void*>(record));
+    }
+    held.clear();
+    max_held = nullptr;
+}
+
+}  // namespace garner
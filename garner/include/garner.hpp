@@ -1,6 +1,8 @@
 // Garner -- simple transactional DB interface to an in-memory B+-tree.
 
 #include <atomic>
+#include <functional>
+#include <future>
 #include <iostream>
 #include <string>
 #include <vector>
@@ -34,16 +36,55 @@ struct TxnStats {
     double commit_time = 0.;
 };
 
+/**
+ * Retry policy for running a transaction through Garner::RunTxn.
+ *
+ * Before the k-th retry, the caller backs off for a random duration drawn
+ * uniformly from [0, min(backoff_max_us, backoff_base_us * 2^(k-1))]
+ * microseconds. After fallback_after aborts, the transaction switches to a
+ * pessimistic mode in which it runs exclusively w.r.t. other RunTxn callers,
+ * so that hot-key transactions cannot livelock each other.
+ */
+struct RetryPolicy {
+    unsigned max_retries = 64;  // 0 means retry until committed
+    unsigned backoff_base_us = 1;
+    unsigned backoff_max_us = 1000;
+    unsigned fallback_after = 8;  // 0 disables pessimistic fallback
+};
+
 /**
  * Transaction concurrency control protocols enum.
  */
 typedef enum TxnProtocol {
-    PROTOCOL_NONE,     // no concurrency control
-    PROTOCOL_SILO,     // simplified Silo
-    PROTOCOL_SILO_HV,  // Silo with hierarchical validation
-    PROTOCOL_SILO_NR   // Silo with no read validation as performance roofline
+    PROTOCOL_NONE,         // no concurrency control
+    PROTOCOL_SILO,         // simplified Silo
+    PROTOCOL_SILO_HV,      // Silo with hierarchical validation
+    PROTOCOL_SILO_NR,      // Silo with no read validation as perf roofline
+    PROTOCOL_SILO_AD,      // Silo choosing per transaction whether to use HV
+    PROTOCOL_2PL_NOWAIT,   // two-phase locking, abort on any conflict
+    PROTOCOL_2PL_WAITDIE,  // two-phase locking, wait-die on conflicts
+    PROTOCOL_TICTOC        // TicToc timestamp-based OCC
 } TxnProtocol;
 
+/**
+ * Transaction access modes enum.
+ */
+typedef enum TxnMode {
+    TXN_READ_WRITE,  // general transaction
+    TXN_READ_ONLY,   // issues only Get and Scan; commits without locking
+    TXN_SNAPSHOT     // read-only on a recent snapshot; never validated,
+                     // except under PROTOCOL_TICTOC (see StartTxn)
+} TxnMode;
+
+/**
+ * Transaction isolation levels enum, weakest last.
+ */
+typedef enum TxnIsolation {
+    ISOLATION_SERIALIZABLE,   // default; equivalent to some serial order
+    ISOLATION_SNAPSHOT,       // snapshot reads, first committer wins on writes
+    ISOLATION_READ_COMMITTED  // latest committed reads, atomic writes
+} TxnIsolation;
+
 /**
  * Garner in-memory KV-DB interface.
  *
@@ -55,6 +96,16 @@ class Garner {
     typedef std::string KType;
     typedef std::string VType;
 
+    /**
+     * A transaction of a deterministic batch, see RunBatch. body issues its
+     * operations through this interface without a transaction context.
+     */
+    struct BatchTxn {
+        std::vector<KType> read_keys;
+        std::vector<KType> write_keys;
+        std::function<void()> body;
+    };
+
     /**
      * Opens a Gerner KV-DB, returning a pointer to the interface on success.
      * The returned interface is thread-safe and can be used by multiple
@@ -63,8 +114,31 @@ class Garner {
      * Exceptions might be thrown.
      *
      * The returned struct should be deleted when no longer needed.
+     *
+     * For hierarchical validation protocols, hv_max_height sets the height
+     * (leaves being 1) above which tree pages are not tracked for validation.
+     * Pages near the root change with almost every write, so tracking them
+     * rarely pays off. 0 means tracking all the way from the root.
+     *
+     * If sched_workers is non-zero, a transaction scheduler with that many
+     * worker threads is started for SubmitTxn.
+     *
+     * For hierarchical validation protocols, hv_stripe_height sets the height
+     * at and above which tree pages, and always the root, split their writer
+     * count into per-core stripes. Committing writers then stop contending
+     * on those pages' cache lines, at the cost of validating readers summing
+     * up all stripes. 0 means no striping.
+     *
+     * For the Silo protocols other than PROTOCOL_SILO_NR, hot_locking makes
+     * transactions lock records that keep failing validation at access time,
+     * as in MOCC. The locks are advisory: holders still validate their
+     * reads, and autocommit writes never wait on them.
      */
-    static Garner* Open(size_t degree, TxnProtocol protocol);
+    static Garner* Open(size_t degree, TxnProtocol protocol,
+                        unsigned hv_max_height = 0,
+                        unsigned sched_workers = 0,
+                        unsigned hv_stripe_height = 0,
+                        bool hot_locking = false);
 
     Garner() = default;
 
@@ -77,9 +151,56 @@ class Garner {
      * Start a transaction by creating a transaction context to be passed in
      * to subsequent operations of the transactio.
      *
+     * A TXN_READ_ONLY transaction keeps no write set and skips the locking
+     * phase; it commits after a single check that everything it read is
+     * still current, so it is never aborted by writers to unrelated keys.
+     * Issuing Put or Delete through it throws.
+     *
+     * A TXN_SNAPSHOT transaction is read-only as well, but reads the state
+     * as of an epoch boundary shortly before its first read from the
+     * records' version chains. It needs no validation and is never aborted
+     * by writers, unless it outlives the versions kept for it. The snapshot
+     * lags behind by up to two epochs, so it may miss the client's own most
+     * recent commits.
+     *
+     * Under PROTOCOL_TICTOC, commit timestamps do not follow epochs, so both
+     * read-only modes run as validated TicToc transactions reading the
+     * latest values instead; they may then be aborted by concurrent writers
+     * like any other reader.
+     *
+     * A TXN_READ_WRITE transaction may ask for a weaker isolation level than
+     * ISOLATION_SERIALIZABLE, trading guarantees for fewer aborts and less
+     * bookkeeping. Both weaker levels never see uncommitted writes, install
+     * all writes atomically at commit, and apply Merges on the latest value.
+     *
+     * Under ISOLATION_SNAPSHOT, all reads come from the same snapshot as for
+     * TXN_SNAPSHOT, taken upon the first operation, overlaid with the
+     * transaction's own writes. Nothing read is validated, but commit aborts
+     * if any record written (other than through Merge) changed since the
+     * transaction read it from the snapshot, or since it was first written
+     * if never read, so the first committer of concurrent writers of a
+     * record wins. Write skew between transactions writing different records
+     * remains possible. As the snapshot lags behind by up to two epochs,
+     * reading and then writing a record written that recently aborts as
+     * well, since the write would lose the newer version; blind writes and
+     * Merges do not.
+     *
+     * Under ISOLATION_READ_COMMITTED, every read returns the latest committed
+     * value at the time it is made, and nothing read is tracked or validated;
+     * repeated reads and scans may see different states. Updates are applied
+     * at commit time like Merges, so unless the record is read afterwards in
+     * the transaction, they never lose concurrent writes. Only conflicts with
+     * hot-record locks of other transactions can abort it.
+     *
+     * Isolation levels are implemented by the Silo family of protocols; other
+     * protocols, as well as read-only modes, run at ISOLATION_SERIALIZABLE,
+     * which satisfies any requested level.
+     *
      * Exceptions might be thrown.
      */
-    virtual TxnCxt<KType, VType>* StartTxn() = 0;
+    virtual TxnCxt<KType, VType>* StartTxn(
+        TxnMode mode = TXN_READ_WRITE,
+        TxnIsolation isolation = ISOLATION_SERIALIZABLE) = 0;
 
     /**
      * Attempt validation and commit of transaction.
@@ -94,6 +215,65 @@ class Garner {
                            uint64_t* ser_order = nullptr,
                            TxnStats* stats = nullptr) = 0;
 
+    /**
+     * Returns true if the transaction is already known to abort, e.g. it has
+     * observed a stale read. Subsequent operations of a doomed transaction
+     * return early without doing work; the client may stop issuing them and
+     * call FinishTxn right away, which will return false.
+     */
+    virtual bool TxnDoomed(const TxnCxt<KType, VType>* txn) const = 0;
+
+    /**
+     * Run a transaction to commit, re-executing body on abort according to
+     * the given retry policy. body issues the transaction's operations on
+     * the given context and may be called multiple times, so it should reset
+     * any output it gathers. Sets nretries to the number of re-executions if
+     * given.
+     *
+     * Returns true if committed, or false if retries are exhausted.
+     *
+     * Exceptions thrown by body abort the transaction and are propagated.
+     */
+    virtual bool RunTxn(std::function<void(TxnCxt<KType, VType>*)> body,
+                        const RetryPolicy& policy = RetryPolicy(),
+                        unsigned* nretries = nullptr) = 0;
+
+    /**
+     * Submit a transaction to the scheduler, which runs it through RunTxn on
+     * one of its worker threads. keys declares (or predicts) the keys body
+     * may access; transactions with overlapping keys are queued onto the
+     * same worker to run one after another instead of aborting each other.
+     * Declaring keys inexactly only affects performance, not correctness.
+     *
+     * body must not wait on the future of another submitted transaction.
+     *
+     * Returns a future that is set to RunTxn's result, or to the exception
+     * body threw. Throws if the scheduler is not enabled at Open.
+     */
+    virtual std::future<bool> SubmitTxn(
+        std::function<void(TxnCxt<KType, VType>*)> body,
+        const std::vector<KType>& keys,
+        const RetryPolicy& policy = RetryPolicy()) = 0;
+
+    /**
+     * Run a batch of transactions deterministically on nworkers threads,
+     * with the same outcome as running them serially in the given order.
+     * Each transaction declares the keys it reads and writes; transactions
+     * are ordered by their conflicts on these keys only, and run once all
+     * earlier conflicting ones have finished. No validation is done and no
+     * transaction ever aborts.
+     *
+     * Bodies must access only the keys they declare, issuing operations
+     * without a transaction context (txn nullptr). Other transactions should
+     * not write the batch's keys meanwhile, and may observe the writes of a
+     * batch transaction partially.
+     *
+     * Exceptions thrown by bodies are propagated after the whole batch has
+     * run; writes of a throwing body done before the throw stay in effect.
+     */
+    virtual void RunBatch(const std::vector<BatchTxn>& batch,
+                          unsigned nworkers) = 0;
+
     /**
      * Insert a key-value pair into B+ tree.
      *
@@ -108,6 +288,55 @@ class Garner {
     virtual bool Put(KType key, VType value,
                      TxnCxt<KType, VType>* txn = nullptr) = 0;
 
+    /**
+     * Replace the value of key with fn(value, found) applied to its current
+     * value, inserting key if not found (in which case value is empty).
+     *
+     * Under Silo protocols, if the read turns out stale at commit time and
+     * its value has not been observed by the transaction otherwise, the
+     * transaction is repaired instead of aborted: fn is re-run on the
+     * latest value while the write locks are held. fn should therefore be
+     * a cheap function of its arguments that does not throw or call into
+     * Garner, and may be run more than once.
+     *
+     * If txn is nullptr, this operation will automatically be treated as a
+     * single-op transaction.
+     *
+     * If txn is nullptr, returns true if successfully committed, or false if
+     * aborted. If txn is given, always returns false.
+     *
+     * Exceptions might be thrown.
+     */
+    virtual bool Update(const KType& key,
+                        std::function<VType(const VType&, bool)> fn,
+                        TxnCxt<KType, VType>* txn = nullptr) = 0;
+
+    /**
+     * Replace the value of key with merge_fn(value, found, delta) applied to
+     * its current value, inserting key if not found (in which case value is
+     * empty).
+     *
+     * Unlike Update, the transaction does not observe the value, so under
+     * Silo protocols merge_fn is applied only at commit time while the
+     * record is locked, and the key is not validated as a read. Concurrent
+     * Merges to the same key, e.g. counter increments, thus never abort
+     * each other. Reading the key later in the same transaction turns the
+     * Merge into an ordinary read-modify-write. merge_fn should be a cheap
+     * function of its arguments that does not throw or call into Garner.
+     *
+     * If txn is nullptr, this operation will automatically be treated as a
+     * single-op transaction.
+     *
+     * If txn is nullptr, returns true if successfully committed, or false if
+     * aborted. If txn is given, always returns false.
+     *
+     * Exceptions might be thrown.
+     */
+    virtual bool Merge(
+        const KType& key, VType delta,
+        std::function<VType(const VType&, bool, const VType&)> merge_fn,
+        TxnCxt<KType, VType>* txn = nullptr) = 0;
+
     /**
      * Search for a key, fill given reference with value and set found to true.
      * If not found, set found to false.
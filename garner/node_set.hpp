@@ -0,0 +1,92 @@
+// NodeSet -- leaf node versions observed by a transaction, for detecting
+// phantoms as in Masstree/Silo.
+
+#include <atomic>
+#include <cassert>
+#include <cstdint>
+#include <iostream>
+#include <vector>
+
+#include "page.hpp"
+#include "small_map.hpp"
+
+#pragma once
+
+namespace garner {
+
+/**
+ * Set of leaf pages observed by negative lookups and scans of a
+ * transaction, each with the node version it had when first observed.
+ *
+ * A leaf's node version is bumped on every new key and on every split, so
+ * a transaction that finds all observed leaves at their recorded versions
+ * at commit has not missed any key inserted into the ranges it looked at.
+ */
+template <typename K>
+class NodeSet {
+   public:
+    struct NodeListItem {
+        Page<K>* page;
+        uint64_t version;
+    };
+
+   private:
+    std::vector<NodeListItem> node_vec;
+
+    // leaf -> index in node_vec
+    SmallMap<Page<K>*, size_t, 16> node_idx;
+
+   public:
+    NodeSet() : node_vec(), node_idx() {}
+
+    NodeSet(const NodeSet&) = delete;
+    NodeSet& operator=(const NodeSet&) = delete;
+
+    ~NodeSet() = default;
+
+    void Clear();
+
+    /**
+     * Observe leaf at its current node version. Returns false if leaf got a
+     * new key or split since I first observed it.
+     */
+    bool Observe(Page<K>* leaf);
+
+    /**
+     * Account for my own insertion into leaf, which had old_node_ver before
+     * it, possibly splitting it into split_lpage and split_rpage. Must still
+     * hold leaf write-latched.
+     */
+    void Inserted(Page<K>* leaf, uint64_t old_node_ver, Page<K>* split_lpage,
+                  Page<K>* split_rpage);
+
+    /**
+     * Returns true if every observed leaf is still at its observed version.
+     */
+    bool Validate() const;
+
+    typename std::vector<NodeListItem>::const_iterator begin() const {
+        return node_vec.begin();
+    }
+    typename std::vector<NodeListItem>::const_iterator end() const {
+        return node_vec.end();
+    }
+
+    template <typename KK>
+    friend std::ostream& operator<<(std::ostream& s,
+                                    const NodeSet<KK>& node_set);
+};
+
+template <typename K>
+std::ostream& operator<<(std::ostream& s, const NodeSet<K>& node_set) {
+    s << "NodeSet{[";
+    for (auto&& [p, ver] : node_set.node_vec)
+        s << "(" << p << "-" << ver << "),";
+    s << "]}";
+    return s;
+}
+
+}  // namespace garner
+
+// Include template implementation in-place.
+#include "node_set.tpl.hpp"
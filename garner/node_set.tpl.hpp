@@ -0,0 +1,60 @@
+// Template implementation included in-place by the ".hpp".
+
+#pragma once
+
+namespace garner {
+
+template <typename K>
+void NodeSet<K>::Clear() {
+    node_vec.clear();
+    node_idx.Clear();
+}
+
+template <typename K>
+bool NodeSet<K>::Observe(Page<K>* leaf) {
+    uint64_t node_ver = leaf->node_ver.load(std::memory_order_acquire);
+    const size_t* idx = node_idx.Find(leaf);
+    if (idx != nullptr) {
+        assert(*idx < node_vec.size());
+        return node_vec[*idx].version == node_ver;
+    }
+    node_vec.push_back(NodeListItem{.page = leaf, .version = node_ver});
+    node_idx.Insert(leaf, node_vec.size() - 1);
+    return true;
+}
+
+template <typename K>
+void NodeSet<K>::Inserted(Page<K>* leaf, uint64_t old_node_ver,
+                          Page<K>* split_lpage, Page<K>* split_rpage) {
+    // my own insertion is not a phantom to me; if the leaf was modified by
+    // others in between, leave the stale version for validation to catch
+    size_t* idx = node_idx.Find(leaf);
+    if (idx == nullptr) return;
+    assert(*idx < node_vec.size());
+    if (node_vec[*idx].version != old_node_ver) return;
+
+    // leaf is still write-latched by me, so its version is stable
+    node_vec[*idx].version = leaf->node_ver.load(std::memory_order_relaxed);
+
+    // if split, the observed key range is now shared with new leaf pages,
+    // which must be observed as well
+    for (Page<K>* page : {split_lpage, split_rpage}) {
+        if (page == nullptr) continue;
+        node_vec.push_back(NodeListItem{
+            .page = page,
+            .version = page->node_ver.load(std::memory_order_relaxed)});
+        node_idx.Insert(page, node_vec.size() - 1);
+    }
+}
+
+template <typename K>
+bool NodeSet<K>::Validate() const {
+    for (auto&& nitem : node_vec) {
+        if (nitem.page->node_ver.load(std::memory_order_acquire) !=
+            nitem.version)
+            return false;
+    }
+    return true;
+}
+
+}  // namespace garner
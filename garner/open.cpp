@@ -4,8 +4,12 @@
 
 namespace garner {
 
-Garner* Garner::Open(size_t degree, TxnProtocol protocol) {
-    GarnerImpl* impl = new GarnerImpl(degree, protocol);
+Garner* Garner::Open(size_t degree, TxnProtocol protocol,
+                     unsigned hv_max_height, unsigned sched_workers,
+                     unsigned hv_stripe_height, bool hot_locking) {
+    GarnerImpl* impl =
+        new GarnerImpl(degree, protocol, hv_max_height, sched_workers,
+                       hv_stripe_height, hot_locking);
     if (impl == nullptr)
         throw GarnerException("failed to allocate GarnerImpl instance");
 
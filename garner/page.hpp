@@ -3,8 +3,10 @@
 #include <algorithm>
 #include <atomic>
 #include <iostream>
+#include <memory>
 #include <optional>
 #include <shared_mutex>
+#include <thread>
 #include <vector>
 
 #include "common.hpp"
@@ -39,6 +41,29 @@ static inline std::string PageTypeStr(PageType type) {
     }
 }
 
+/**
+ * Stripes of hv_sem for hot pages near the root, each on its own cache
+ * line. A writer only touches the stripe of its own thread, while readers
+ * sum up all stripes. One stripe per core, up to a limit.
+ */
+struct alignas(64) HVSemStripe {
+    std::atomic<uint64_t> count{0};
+};
+
+inline size_t HVSemNumStripes() {
+    static const size_t nstripes =
+        std::clamp(std::thread::hardware_concurrency(), 1U, 64U);
+    return nstripes;
+}
+
+inline size_t HVSemLocalStripe() {
+    static std::atomic<size_t> next_stripe{0};
+    thread_local const size_t stripe =
+        next_stripe.fetch_add(1, std::memory_order_relaxed) %
+        HVSemNumStripes();
+    return stripe;
+}
+
 /**
  * Page base class, containing common metadata and vector of keys.
  * Each page type derives its own sub-type.
@@ -59,9 +84,22 @@ struct Page {
     // read-write mutex as latch
     std::shared_mutex latch;
 
-    // tree node semaphore & version number for hierarchical validation
+    // tree node semaphore & version number for hierarchical validation;
+    // the semaphore is split into per-core stripes if hv_sem_stripes is
+    // set, which happens before the page gets published and never changes
     std::atomic<uint64_t> hv_sem;
     std::atomic<uint64_t> hv_ver;
+    std::unique_ptr<HVSemStripe[]> hv_sem_stripes;
+
+    // leaf node version for phantom detection, bumped on every new key
+    // insertion into and every split of a leaf; modified only under write
+    // latch
+    std::atomic<uint64_t> node_ver;
+
+    // max TicToc commit timestamp of transactions that observed this leaf's
+    // key range, inherited by leaves split from it; a later insertion into
+    // the range must commit after it
+    std::atomic<uint64_t> tictoc_rts;
 
     // sorted list of keys
     std::vector<K> keys;
@@ -74,6 +112,9 @@ struct Page {
           latch(),
           hv_sem(0),
           hv_ver(0),
+          hv_sem_stripes(),
+          node_ver(0),
+          tictoc_rts(0),
           keys() {
         keys.reserve(degree);
     }
@@ -99,6 +140,58 @@ struct Page {
      * Must have read latch held.
      */
     ssize_t SearchKey(const K& key) const;
+
+    /**
+     * Hint the CPU to start fetching hv_sem (or its stripes) & hv_ver ahead
+     * of validation.
+     */
+    void PrefetchHV() const {
+        if (hv_sem_stripes) {
+            size_t nstripes = HVSemNumStripes();
+            for (size_t i = 0; i < nstripes; ++i)
+                __builtin_prefetch(&hv_sem_stripes[i].count);
+        } else
+            __builtin_prefetch(&hv_sem);
+        __builtin_prefetch(&hv_ver);
+    }
+
+    /**
+     * Split hv_sem of a freshly allocated page into stripes.
+     */
+    void StripeHVSem() {
+        assert(!hv_sem_stripes);
+        hv_sem_stripes = std::make_unique<HVSemStripe[]>(HVSemNumStripes());
+    }
+
+    /**
+     * Increment/decrement hv_sem as a writer through this page, on the
+     * calling thread's stripe if striped.
+     */
+    void HoldHVSem() {
+        if (hv_sem_stripes)
+            ++hv_sem_stripes[HVSemLocalStripe()].count;
+        else
+            ++hv_sem;
+    }
+    void ReleaseHVSem() {
+        if (hv_sem_stripes)
+            --hv_sem_stripes[HVSemLocalStripe()].count;
+        else
+            --hv_sem;
+    }
+
+    /**
+     * Number of writers currently through this page, summing up stripes.
+     * A writer holding the semaphore throughout the summing is always
+     * counted; others are at worst counted spuriously.
+     */
+    uint64_t LoadHVSem() const {
+        if (!hv_sem_stripes) return hv_sem;
+        uint64_t sum = 0;
+        for (size_t i = 0; i < HVSemNumStripes(); ++i)
+            sum += hv_sem_stripes[i].count;
+        return sum;
+    }
 };
 
 template <typename K>
@@ -0,0 +1,38 @@
+// Batched validation of Silo-style record reads at commit time.
+
+#include <algorithm>
+#include <cstdint>
+#include <type_traits>
+
+#include "record.hpp"
+
+#pragma once
+
+namespace garner {
+
+// number of reads validated per batch; TID words of the next batch are
+// prefetched while the current one is checked, so that cache misses on
+// long read lists overlap instead of being taken one by one
+constexpr size_t VALIDATE_BATCH = 16;
+
+/**
+ * Validate the reads in [begin, end), items with the record read, the
+ * version read, and whether the read is repairable, batch by batch.
+ *
+ * A branch-free pass flags a batch if any record is locked, maybe by me,
+ * or has a version other than the one read; in the common case of nothing
+ * flagged, this is all. Records of a flagged batch are checked exactly:
+ * locked_by_me(record) tells if a locked record is in my write set, and
+ * repair(record) repairs a repairable stale read.
+ *
+ * Must hold all write locks. Returns false if any read is stale and cannot
+ * be repaired.
+ */
+template <typename It, typename LockedByMe, typename Repair>
+bool ValidateReadBatches(It begin, It end, LockedByMe&& locked_by_me,
+                         Repair&& repair);
+
+}  // namespace garner
+
+// Include template implementation in-place.
+#include "read_validation.tpl.hpp"
@@ -0,0 +1,53 @@
+// Template implementation included in-place by the ".hpp".
+
+#pragma once
+
+namespace garner {
+
+template <typename It, typename LockedByMe, typename Repair>
+bool ValidateReadBatches(It begin, It end, LockedByMe&& locked_by_me,
+                         Repair&& repair) {
+    using RecordT = std::remove_pointer_t<decltype(begin->record)>;
+
+    size_t nreads = end - begin;
+    for (size_t i = 0; i < std::min(VALIDATE_BATCH, nreads); ++i)
+        begin[i].record->PrefetchTid();
+
+    uint64_t tids[VALIDATE_BATCH];
+    for (size_t bbegin = 0; bbegin < nreads; bbegin += VALIDATE_BATCH) {
+        size_t bend = std::min(bbegin + VALIDATE_BATCH, nreads);
+        for (size_t i = bend; i < std::min(bend + VALIDATE_BATCH, nreads); ++i)
+            begin[i].record->PrefetchTid();
+
+        bool flagged = false;
+        for (size_t i = bbegin; i < bend; ++i) {
+            uint64_t tid = begin[i].record->LoadTid();
+            tids[i - bbegin] = tid;
+            flagged |= RecordT::TidLocked(tid) |
+                       (RecordT::TidVersion(tid) != begin[i].version);
+        }
+        if (!flagged) continue;
+
+        for (size_t i = bbegin; i < bend; ++i) {
+            auto&& ritem = begin[i];
+            uint64_t curr_tid = tids[i - bbegin];
+
+            // if possibly locked by some writer other than me, abort
+            if (RecordT::TidLocked(curr_tid) && !locked_by_me(ritem.record)) {
+                ritem.record->BumpTemperature();
+                return false;
+            }
+
+            // if version mismatch, abort unless the read can be repaired; a
+            // repairable record is in my write set, so it is locked by me
+            // and cannot change again before my install
+            if (ritem.version != RecordT::TidVersion(curr_tid)) {
+                ritem.record->BumpTemperature();
+                if (!ritem.repairable || !repair(ritem.record)) return false;
+            }
+        }
+    }
+    return true;
+}
+
+}  // namespace garner
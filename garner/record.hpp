@@ -1,7 +1,12 @@
 // Record -- record/row struct containing value, pointed to by leaf nodes.
 
+#include <algorithm>
+#include <atomic>
+#include <cstdint>
 #include <iostream>
-#include <shared_mutex>
+
+#include "common.hpp"
+#include "epoch.hpp"
 
 #pragma once
 
@@ -11,42 +16,311 @@ namespace garner {
  * Record struct containing user value. Leaf nodes of the B+-tree point to
  * such record structs.
  *
- * Before accessing the value, should have appropriate latch held.
+ * Concurrency control state lives in a single atomic TID word, as in Silo:
+ * - bit 63: lock bit, held by a writer while installing a new value
+ * - bit 62: valid bit, set at first committed write
+ * - bits 0..61: version number
+ *
+ * Readers never write to the record; they read the value seqlock-style
+ * between two loads of the TID word. Writers lock the TID word with CAS.
+ * The value object is swapped out on each write rather than modified in
+ * place, and the old object is reclaimed through epoch-based reclamation,
+ * so a concurrent reader never copies from freed memory.
+ *
+ * Replaced values are kept in a short chain of older versions, newest
+ * first, for snapshot reads. Since snapshots are taken at epoch boundaries,
+ * only the last version of each epoch can ever be read by one, as in Silo;
+ * a value replaced within the epoch it was written in is retired right
+ * away. The chain holds at most MAX_OLD_VERSIONS entries; versions falling
+ * off its end are retired through epoch-based reclamation as well.
+ *
+ * Two-phase locking protocols additionally keep a shared/exclusive lock on
+ * the record in a separate word, held for the whole transaction; the TID
+ * word lock is still taken around installing values. Silo transactions
+ * take the same lock on hot records at access time, as in MOCC, where a
+ * record's temperature counts its recent validation failures, halved with
+ * each epoch passed.
+ *
+ * TicToc keeps the logical write and read timestamps of the current version
+ * in another word, packed as in the TicToc paper:
+ * - bit 63: lock bit, held by a committing writer
+ * - bits 48..62: delta of read timestamp over write timestamp
+ * - bits 0..47: write timestamp
+ * Readers extend the read timestamp with CAS. A TicToc writer holds this
+ * lock across its whole commit and the TID word lock only while installing.
+ *
+ * A record inserted by a transaction that aborts stays a phantom, i.e., not
+ * valid, forever. Every transaction handed a phantom record by the tree pins
+ * it until finishing, and the last one to unpin it unlinks it from its leaf
+ * if it is still a phantom, see BPTree::RemovePhantom.
  */
 template <typename K, typename V>
 struct Record {
-    // read-write mutex as latch
-    std::shared_mutex latch;
+    static constexpr uint64_t TID_LOCK_BIT = 1UL << 63;
+    static constexpr uint64_t TID_VALID_BIT = 1UL << 62;
+    static constexpr uint64_t TID_VERSION_MASK = TID_VALID_BIT - 1;
+
+    // 2PL lock word: bit 63 latches the lock state itself, bit 62 is set
+    // if held exclusively, and the low bits count shared holders
+    static constexpr uint64_t LOCK_2PL_LATCH_BIT = 1UL << 63;
+    static constexpr uint64_t LOCK_2PL_EXCL_BIT = 1UL << 62;
+
+    // TicToc timestamp word: lock bit, 15-bit rts delta, 48-bit wts
+    static constexpr uint64_t TICTOC_LOCK_BIT = 1UL << 63;
+    static constexpr unsigned TICTOC_DELTA_SHIFT = 48;
+    static constexpr uint64_t TICTOC_DELTA_MAX = (1UL << 15) - 1;
+    static constexpr uint64_t TICTOC_WTS_MASK = (1UL << 48) - 1;
+
+    // temperature word: epoch of last update in the upper bits and a 16-bit
+    // saturating counter in the low bits; a record at or above the hot
+    // temperature gets locked pessimistically by Silo transactions
+    static constexpr unsigned TEMP_BITS = 16;
+    static constexpr uint64_t TEMP_MASK = (1UL << TEMP_BITS) - 1;
+    static constexpr unsigned HOT_TEMPERATURE = 4;
+
+    // max number of older versions kept per record, i.e., number of past
+    // epochs a snapshot can reach back for a frequently written record
+    static constexpr size_t MAX_OLD_VERSIONS = 8;
+
+    /**
+     * An older committed version of the record. Immutable once linked into
+     * the chain, except for being cut off from the older part.
+     */
+    struct Version {
+        const uint64_t version;
+        V* const value;
+
+        // next older version, nullptr if none kept
+        std::atomic<Version*> older;
+
+        // true if older versions existed but have been pruned
+        std::atomic<bool> truncated;
+
+        Version(uint64_t version, V* value)
+            : version(version),
+              value(value),
+              older(nullptr),
+              truncated(false) {}
+        ~Version() { delete value; }
+    };
+
+    // TID word packing lock bit, valid bit, and version number
+    std::atomic<uint64_t> tid;
 
     // a copy of key is stored in the record
     // this field should never be modified after the creation of record, so is
     // safe for reader to access without latching
     const K key;
 
-    // user value
-    V value;
+    // user value, nullptr before the first write
+    std::atomic<V*> value;
+
+    // chain of older versions, newest first, nullptr if none
+    std::atomic<Version*> old_versions;
 
-    // version number
-    // effective only when concurerncy control is on
-    uint64_t version = 0;
+    // 2PL lock word, and a lower bound of timestamps of current 2PL lock
+    // holders, UINT64_MAX if none; the latter is guarded by the latch bit
+    std::atomic<uint64_t> lock_2pl;
+    uint64_t lock_2pl_min_ts;
 
-    // valid flag, set at first write
-    // effective only when concurerncy control is on
-    bool valid = false;
+    // TicToc timestamp word
+    std::atomic<uint64_t> tictoc;
+
+    // temperature word
+    std::atomic<uint64_t> temperature;
+
+    // number of unfinished transactions pinning this record as a phantom
+    std::atomic<uint32_t> npins;
 
     Record() = delete;
-    Record(K key) : latch(), key(key), value(), version(0), valid(false) {}
+    Record(K key)
+        : tid(0),
+          key(key),
+          value(nullptr),
+          old_versions(nullptr),
+          lock_2pl(0),
+          lock_2pl_min_ts(UINT64_MAX),
+          tictoc(0),
+          temperature(0),
+          npins(0) {}
 
     Record(const Record&) = delete;
     Record& operator=(const Record&) = delete;
 
-    ~Record() = default;
+    ~Record();
+
+    /**
+     * Helpers for decoding a TID word.
+     */
+    static bool TidLocked(uint64_t tid) { return (tid & TID_LOCK_BIT) != 0; }
+    static bool TidValid(uint64_t tid) { return (tid & TID_VALID_BIT) != 0; }
+    static uint64_t TidVersion(uint64_t tid) { return tid & TID_VERSION_MASK; }
+
+    /**
+     * Helpers for decoding a TicToc timestamp word.
+     */
+    static bool TicTocLocked(uint64_t word) {
+        return (word & TICTOC_LOCK_BIT) != 0;
+    }
+    static uint64_t TicTocWts(uint64_t word) { return word & TICTOC_WTS_MASK; }
+    static uint64_t TicTocRts(uint64_t word) {
+        return TicTocWts(word) +
+               ((word & ~TICTOC_LOCK_BIT) >> TICTOC_DELTA_SHIFT);
+    }
+
+    /**
+     * Load current TID word.
+     */
+    uint64_t LoadTid() const { return tid.load(std::memory_order_acquire); }
+
+    /**
+     * Hint the CPU to start fetching the TID word ahead of a LoadTid.
+     */
+    void PrefetchTid() const { __builtin_prefetch(&tid); }
+
+    /**
+     * Lock the TID word, spinning while held by someone else.
+     */
+    void Lock();
+
+    /**
+     * Try to lock the TID word once. Returns true on success.
+     */
+    bool TryLock();
+
+    /**
+     * Unlock the TID word without changing version. Must hold lock.
+     */
+    void Unlock();
+
+    /**
+     * Set the record valid with a new version and unlock in one store. Must
+     * hold lock.
+     */
+    void UnlockWithVersion(uint64_t version);
+
+    /**
+     * Try to acquire the 2PL lock once, in exclusive or shared mode, on
+     * behalf of a transaction with given timestamp. If upgrade is true, the
+     * caller is holding the lock shared and wants it exclusive. Returns true
+     * on success; otherwise sets min_ts to a lower bound of the current
+     * holders' timestamps.
+     */
+    bool TryLock2PL(bool exclusive, bool upgrade, uint64_t ts,
+                    uint64_t& min_ts);
+
+    /**
+     * Release the 2PL lock held in given mode.
+     */
+    void Unlock2PL(bool exclusive);
+
+    /**
+     * Get current temperature, decayed by the epochs passed since its last
+     * bump. Returns true if at or above the hot temperature.
+     */
+    unsigned Temperature() const;
+    bool IsHot() const { return Temperature() >= HOT_TEMPERATURE; }
+
+    /**
+     * Bump temperature by one upon a validation failure on the record.
+     */
+    void BumpTemperature();
+
+    /**
+     * Pin/unpin the record against removal as a phantom. Unpin returns the
+     * number of pins left.
+     */
+    void Pin() { npins.fetch_add(1, std::memory_order_relaxed); }
+    uint32_t Unpin() {
+        return npins.fetch_sub(1, std::memory_order_acq_rel) - 1;
+    }
+    bool Pinned() const { return npins.load(std::memory_order_acquire) > 0; }
+
+    /**
+     * Returns true if the 2PL lock is held by anyone.
+     */
+    bool Locked2PL() const {
+        return lock_2pl.load(std::memory_order_acquire) != 0;
+    }
+
+    /**
+     * Load current TicToc timestamp word.
+     */
+    uint64_t LoadTicToc() const {
+        return tictoc.load(std::memory_order_acquire);
+    }
+
+    /**
+     * Lock the TicToc timestamp word, spinning while held by someone else.
+     * Returns the word as of locking.
+     */
+    uint64_t LockTicToc();
+
+    /**
+     * Unlock the TicToc timestamp word without changing timestamps, or
+     * with a new version's timestamps set to wts. Must hold lock.
+     */
+    void UnlockTicToc();
+    void UnlockTicTocWithTs(uint64_t wts);
+
+    /**
+     * Extend the read timestamp of the version with given write timestamp
+     * to at least rts. Returns false if the version has been replaced or is
+     * locked by a writer. The write timestamp may get shifted up if the
+     * delta would overflow.
+     */
+    bool ExtendTicTocRts(uint64_t wts, uint64_t rts);
+
+    /**
+     * Same as ReadConsistent, additionally returning the unlocked TicToc
+     * timestamp word matching the value read.
+     */
+    uint64_t ReadConsistentTicToc(V& value, uint64_t& word) const;
+
+    /**
+     * Read a consistent snapshot of value; spins while the record is locked
+     * by a writer. Returns the (unlocked) TID word the value corresponds to.
+     * If that TID is not valid, value is left untouched.
+     */
+    uint64_t ReadConsistent(V& value) const;
+
+    /**
+     * Read value while holding lock, so it cannot change underneath. Returns
+     * false and leaves value untouched if the record is not valid.
+     */
+    bool ReadLocked(V& value) const;
+
+    /**
+     * Read the value as of the start of given snapshot epoch, i.e. of the
+     * newest version committed in an earlier epoch; spins while the record
+     * is locked by a writer. Returns the TID word the value corresponds to.
+     * If that TID is not valid, the record had no such version and value is
+     * left untouched; in that case too_old is set if the version existed but
+     * has been pruned from the chain.
+     */
+    uint64_t ReadSnapshot(uint64_t snap_epoch, V& value, bool& too_old) const;
+
+    /**
+     * Replace the value object with one to be committed under given version,
+     * moving the old one into the version chain if written in an earlier
+     * epoch and pruning the chain to its max length. Must hold lock.
+     */
+    void InstallValue(V new_value, uint64_t new_version);
 };
 
 template <typename K, typename V>
 std::ostream& operator<<(std::ostream& s, const Record<K, V>& record) {
-    s << "Record{key=" << record.key << ",value=" << record.value << "}";
+    V* value = record.value.load();
+    s << "Record{key=" << record.key << ",value=";
+    if (value != nullptr)
+        s << *value;
+    else
+        s << "(null)";
+    s << ",tid=" << std::hex << record.tid.load() << std::dec << "}";
     return s;
 }
 
 }  // namespace garner
+
+// Include template implementation in-place.
+#include "record.tpl.hpp"
@@ -0,0 +1,308 @@
+// Template implementation included in-place by the ".hpp".
+
+#pragma once
+
+namespace garner {
+
+template <typename K, typename V>
+Record<K, V>::~Record() {
+    delete value.load();
+    Version* ver = old_versions.load();
+    while (ver != nullptr) {
+        Version* older = ver->older.load();
+        delete ver;
+        ver = older;
+    }
+}
+
+template <typename K, typename V>
+void Record<K, V>::Lock() {
+    while (true) {
+        uint64_t curr = tid.load(std::memory_order_relaxed);
+        if (!TidLocked(curr) &&
+            tid.compare_exchange_weak(curr, curr | TID_LOCK_BIT,
+                                      std::memory_order_acquire))
+            return;
+    }
+}
+
+template <typename K, typename V>
+bool Record<K, V>::TryLock() {
+    uint64_t curr = tid.load(std::memory_order_relaxed);
+    if (TidLocked(curr)) return false;
+    return tid.compare_exchange_strong(curr, curr | TID_LOCK_BIT,
+                                       std::memory_order_acquire);
+}
+
+template <typename K, typename V>
+void Record<K, V>::Unlock() {
+    assert(TidLocked(tid.load()));
+    tid.fetch_and(~TID_LOCK_BIT, std::memory_order_release);
+}
+
+template <typename K, typename V>
+void Record<K, V>::UnlockWithVersion(uint64_t version) {
+    assert(TidLocked(tid.load()));
+    assert((version & ~TID_VERSION_MASK) == 0);
+    tid.store(TID_VALID_BIT | version, std::memory_order_release);
+}
+
+template <typename K, typename V>
+bool Record<K, V>::TryLock2PL(bool exclusive, bool upgrade, uint64_t ts,
+                              uint64_t& min_ts) {
+    uint64_t state;
+    while (true) {
+        state = lock_2pl.load(std::memory_order_relaxed);
+        if ((state & LOCK_2PL_LATCH_BIT) == 0 &&
+            lock_2pl.compare_exchange_weak(state, state | LOCK_2PL_LATCH_BIT,
+                                           std::memory_order_acquire))
+            break;
+    }
+
+    bool granted;
+    if (exclusive)
+        granted = upgrade ? (state == 1) : (state == 0);
+    else
+        granted = (state & LOCK_2PL_EXCL_BIT) == 0;
+
+    // the holders' bound only ever gets lowered until the lock is free, so
+    // it may be stale-low, which only makes wait-die more conservative
+    uint64_t new_state = state;
+    if (granted) {
+        new_state = exclusive ? LOCK_2PL_EXCL_BIT : state + 1;
+        lock_2pl_min_ts = std::min(lock_2pl_min_ts, ts);
+    } else
+        min_ts = lock_2pl_min_ts;
+
+    lock_2pl.store(new_state, std::memory_order_release);
+    return granted;
+}
+
+template <typename K, typename V>
+void Record<K, V>::Unlock2PL(bool exclusive) {
+    uint64_t state;
+    while (true) {
+        state = lock_2pl.load(std::memory_order_relaxed);
+        if ((state & LOCK_2PL_LATCH_BIT) == 0 &&
+            lock_2pl.compare_exchange_weak(state, state | LOCK_2PL_LATCH_BIT,
+                                           std::memory_order_acquire))
+            break;
+    }
+
+    assert(exclusive ? (state == LOCK_2PL_EXCL_BIT)
+                     : (state > 0 && (state & LOCK_2PL_EXCL_BIT) == 0));
+    uint64_t new_state = exclusive ? 0 : state - 1;
+    if (new_state == 0) lock_2pl_min_ts = UINT64_MAX;
+
+    lock_2pl.store(new_state, std::memory_order_release);
+}
+
+template <typename K, typename V>
+uint64_t Record<K, V>::ReadConsistent(V& read_value) const {
+    // the value object may get swapped and retired while we copy it
+    EpochGuard guard;
+
+    while (true) {
+        uint64_t tid_before = tid.load(std::memory_order_acquire);
+        if (TidLocked(tid_before)) continue;
+        if (!TidValid(tid_before)) return tid_before;
+
+        V* vptr = value.load(std::memory_order_acquire);
+        assert(vptr != nullptr);
+        V copied = *vptr;
+
+        std::atomic_thread_fence(std::memory_order_acquire);
+        if (tid.load(std::memory_order_relaxed) == tid_before) {
+            read_value = std::move(copied);
+            return tid_before;
+        }
+    }
+}
+
+template <typename K, typename V>
+bool Record<K, V>::ReadLocked(V& read_value) const {
+    uint64_t curr_tid = tid.load(std::memory_order_relaxed);
+    assert(TidLocked(curr_tid));
+    if (!TidValid(curr_tid)) return false;
+
+    // only lock holders install values, so no need to guard against retiring
+    V* vptr = value.load(std::memory_order_relaxed);
+    assert(vptr != nullptr);
+    read_value = *vptr;
+    return true;
+}
+
+template <typename K, typename V>
+unsigned Record<K, V>::Temperature() const {
+    uint64_t word = temperature.load(std::memory_order_relaxed);
+    if (word == 0) return 0;
+    uint64_t epoch = EpochManager::Global().CurrEpoch();
+    uint64_t epochs = epoch - std::min(epoch, word >> TEMP_BITS);
+    if (epochs >= TEMP_BITS) return 0;
+    return (word & TEMP_MASK) >> epochs;
+}
+
+template <typename K, typename V>
+void Record<K, V>::BumpTemperature() {
+    uint64_t epoch = EpochManager::Global().CurrEpoch();
+    uint64_t word = temperature.load(std::memory_order_relaxed);
+    while (true) {
+        uint64_t temp = 0;
+        uint64_t epochs = epoch - std::min(epoch, word >> TEMP_BITS);
+        if (epochs < TEMP_BITS) temp = (word & TEMP_MASK) >> epochs;
+        if (temp < TEMP_MASK) temp++;
+        if (temperature.compare_exchange_weak(word, (epoch << TEMP_BITS) | temp,
+                                              std::memory_order_relaxed))
+            return;
+    }
+}
+
+template <typename K, typename V>
+uint64_t Record<K, V>::LockTicToc() {
+    while (true) {
+        uint64_t curr = tictoc.load(std::memory_order_relaxed);
+        if (!TicTocLocked(curr) &&
+            tictoc.compare_exchange_weak(curr, curr | TICTOC_LOCK_BIT,
+                                         std::memory_order_acquire))
+            return curr;
+    }
+}
+
+template <typename K, typename V>
+void Record<K, V>::UnlockTicToc() {
+    assert(TicTocLocked(tictoc.load()));
+    tictoc.fetch_and(~TICTOC_LOCK_BIT, std::memory_order_release);
+}
+
+template <typename K, typename V>
+void Record<K, V>::UnlockTicTocWithTs(uint64_t wts) {
+    assert(TicTocLocked(tictoc.load()));
+    assert((wts & ~TICTOC_WTS_MASK) == 0);
+    tictoc.store(wts, std::memory_order_release);
+}
+
+template <typename K, typename V>
+bool Record<K, V>::ExtendTicTocRts(uint64_t wts, uint64_t rts) {
+    uint64_t curr = tictoc.load(std::memory_order_acquire);
+    while (true) {
+        if (TicTocWts(curr) != wts) return false;
+        if (TicTocRts(curr) >= rts) return true;
+        if (TicTocLocked(curr)) return false;
+
+        // on delta overflow, shift wts up; this only narrows the version's
+        // valid range from below, making other readers of it re-validate
+        uint64_t new_wts = wts;
+        if (rts - wts > TICTOC_DELTA_MAX) new_wts = rts - TICTOC_DELTA_MAX;
+        uint64_t new_word =
+            new_wts | ((rts - new_wts) << TICTOC_DELTA_SHIFT);
+        if (tictoc.compare_exchange_weak(curr, new_word,
+                                         std::memory_order_acq_rel))
+            return true;
+    }
+}
+
+template <typename K, typename V>
+uint64_t Record<K, V>::ReadConsistentTicToc(V& read_value,
+                                            uint64_t& word) const {
+    // a TicToc writer holds the timestamp word locked across its install,
+    // so an unchanged unlocked word brackets a value of that version
+    while (true) {
+        uint64_t word_before = tictoc.load(std::memory_order_acquire);
+        if (TicTocLocked(word_before)) continue;
+
+        uint64_t read_tid = ReadConsistent(read_value);
+
+        std::atomic_thread_fence(std::memory_order_acquire);
+        if (tictoc.load(std::memory_order_relaxed) == word_before) {
+            word = word_before;
+            return read_tid;
+        }
+    }
+}
+
+template <typename K, typename V>
+uint64_t Record<K, V>::ReadSnapshot(uint64_t snap_epoch, V& read_value,
+                                    bool& too_old) const {
+    // versions may get pruned and retired while we walk the chain
+    EpochGuard guard;
+    too_old = false;
+
+    while (true) {
+        uint64_t tid_before = tid.load(std::memory_order_acquire);
+        if (TidLocked(tid_before)) continue;
+        if (!TidValid(tid_before)) return tid_before;
+
+        // value objects are immutable, so it suffices to take a consistent
+        // pair of pointers and copy from them afterwards
+        V* vptr = value.load(std::memory_order_acquire);
+        Version* ver = old_versions.load(std::memory_order_acquire);
+        std::atomic_thread_fence(std::memory_order_acquire);
+        if (tid.load(std::memory_order_relaxed) != tid_before) continue;
+
+        if (EpochManager::TidEpoch(TidVersion(tid_before)) < snap_epoch) {
+            assert(vptr != nullptr);
+            read_value = *vptr;
+            return tid_before;
+        }
+
+        // versions only get older along the chain; a chain cut off after
+        // the version read here is fine to follow, since the pruned part is
+        // retired, not freed, while we are in the critical section
+        while (ver != nullptr) {
+            if (EpochManager::TidEpoch(ver->version) < snap_epoch) {
+                read_value = *ver->value;
+                return TID_VALID_BIT | ver->version;
+            }
+            Version* older = ver->older.load(std::memory_order_acquire);
+            if (older == nullptr)
+                too_old = ver->truncated.load(std::memory_order_relaxed);
+            ver = older;
+        }
+        return 0;
+    }
+}
+
+template <typename K, typename V>
+void Record<K, V>::InstallValue(V new_value, uint64_t new_version) {
+    uint64_t curr_tid = tid.load(std::memory_order_relaxed);
+    assert(TidLocked(curr_tid));
+    V* vptr = new V(std::move(new_value));
+    if (vptr == nullptr)
+        throw GarnerException("failed to allocate record value");
+
+    V* old_vptr = value.exchange(vptr, std::memory_order_acq_rel);
+    if (old_vptr == nullptr) return;
+
+    // no snapshot boundary lies between the two versions, so no snapshot
+    // will ever read the replaced one
+    uint64_t old_version = TidVersion(curr_tid);
+    if (EpochManager::TidEpoch(old_version) ==
+        EpochManager::TidEpoch(new_version)) {
+        EpochManager::Global().Retire(old_vptr);
+        return;
+    }
+
+    // the replaced value becomes the newest old version
+    Version* ver = new Version(old_version, old_vptr);
+    if (ver == nullptr)
+        throw GarnerException("failed to allocate record version");
+    ver->older.store(old_versions.load(std::memory_order_relaxed),
+                     std::memory_order_relaxed);
+    old_versions.store(ver, std::memory_order_release);
+
+    // prune the chain down to max length; only lock holders modify it
+    for (size_t n = 1; n < MAX_OLD_VERSIONS && ver != nullptr; ++n)
+        ver = ver->older.load(std::memory_order_relaxed);
+    if (ver == nullptr) return;
+    Version* pruned = ver->older.load(std::memory_order_relaxed);
+    if (pruned == nullptr) return;
+    ver->truncated.store(true, std::memory_order_relaxed);
+    ver->older.store(nullptr, std::memory_order_release);
+    while (pruned != nullptr) {
+        Version* older = pruned->older.load(std::memory_order_relaxed);
+        EpochManager::Global().Retire(pruned);
+        pruned = older;
+    }
+}
+
+}  // namespace garner
@@ -0,0 +1,175 @@
+#include "scheduler.hpp"
+
+#include <cassert>
+
+#include <algorithm>
+#include <exception>
+#include <string>
+
+#include "common.hpp"
+
+namespace garner {
+
+TxnScheduler::TxnScheduler(Garner* gn, unsigned nworkers)
+    : gn(gn), mtx(), slots(NUM_SLOTS), workers(), stopping(false), threads() {
+    if (nworkers == 0)
+        throw GarnerException("scheduler needs at least one worker");
+
+    for (unsigned widx = 0; widx < nworkers; ++widx)
+        workers.push_back(std::make_unique<Worker>());
+    for (unsigned widx = 0; widx < nworkers; ++widx)
+        threads.emplace_back([this, widx] { WorkerLoop(widx); });
+}
+
+TxnScheduler::~TxnScheduler() {
+    {
+        std::lock_guard<std::mutex> lock(mtx);
+        stopping = true;
+        for (auto&& worker : workers) worker->cv.notify_one();
+    }
+    // workers exit only once every queue is drained
+    threads.clear();
+}
+
+unsigned TxnScheduler::Route(const Task* task) {
+    unsigned nworkers = workers.size();
+    std::vector<unsigned> nowned(nworkers, 0);
+    for (size_t slot : task->slots) {
+        if (slots[slot].nactive > 0) nowned[slots[slot].owner]++;
+    }
+
+    // join the worker already running most of my potential conflicts
+    unsigned target = std::max_element(nowned.begin(), nowned.end()) -
+                      nowned.begin();
+
+    // otherwise, pick the least loaded worker, preferring idle ones
+    if (nowned[target] == 0) {
+        auto load = [&](unsigned widx) {
+            return workers[widx]->queue.size() + (workers[widx]->idle ? 0 : 1);
+        };
+        for (unsigned widx = 0; widx < nworkers; ++widx) {
+            if (load(widx) < load(target)) target = widx;
+        }
+    }
+
+    for (size_t slot : task->slots) {
+        slots[slot].owner = target;
+        slots[slot].nactive++;
+    }
+    return target;
+}
+
+bool TxnScheduler::Stealable(const Task* task) const {
+    for (size_t slot : task->slots) {
+        assert(slots[slot].nactive > 0);
+        if (slots[slot].nactive > 1) return false;
+    }
+    return true;
+}
+
+TxnScheduler::Task* TxnScheduler::Steal(unsigned widx) {
+    unsigned nworkers = workers.size();
+    for (unsigned i = 1; i < nworkers; ++i) {
+        auto&& queue = workers[(widx + i) % nworkers]->queue;
+
+        // the back holds the most recently routed tasks, which are the
+        // least likely to be depended upon soon; when stopping, anything
+        // goes since no more tasks will be routed
+        for (auto it = queue.rbegin(); it != queue.rend(); ++it) {
+            Task* task = *it;
+            if (!stopping && !Stealable(task)) continue;
+
+            queue.erase(std::next(it).base());
+            for (size_t slot : task->slots) slots[slot].owner = widx;
+            return task;
+        }
+    }
+    return nullptr;
+}
+
+void TxnScheduler::WakeIdle(unsigned widx) {
+    for (unsigned i = 0; i < workers.size(); ++i) {
+        if (i != widx && workers[i]->idle) {
+            workers[i]->cv.notify_one();
+            return;
+        }
+    }
+}
+
+void TxnScheduler::WorkerLoop(unsigned widx) {
+    Worker& worker = *workers[widx];
+    std::unique_lock<std::mutex> lock(mtx);
+
+    while (true) {
+        Task* task = nullptr;
+        if (!worker.queue.empty()) {
+            task = worker.queue.front();
+            worker.queue.pop_front();
+        } else
+            task = Steal(widx);
+
+        if (task == nullptr) {
+            if (stopping) return;
+            worker.idle = true;
+            worker.cv.wait(lock);
+            worker.idle = false;
+            continue;
+        }
+
+        // leftover work of mine may now be taken by idle workers
+        if (!worker.queue.empty()) WakeIdle(widx);
+
+        lock.unlock();
+        try {
+            task->promise.set_value(gn->RunTxn(task->body, task->policy));
+        } catch (...) {
+            task->promise.set_exception(std::current_exception());
+        }
+        lock.lock();
+
+        // slots stay taken until the transaction has finished, so that
+        // conflicting tasks submitted meanwhile queue up behind it
+        for (size_t slot : task->slots) {
+            assert(slots[slot].nactive > 0);
+            slots[slot].nactive--;
+        }
+        delete task;
+    }
+}
+
+std::future<bool> TxnScheduler::Submit(TxnBody body,
+                                       const std::vector<Garner::KType>& keys,
+                                       const RetryPolicy& policy) {
+    Task* task = new Task{.body = std::move(body),
+                          .policy = policy,
+                          .slots = {},
+                          .promise = std::promise<bool>()};
+    if (task == nullptr)
+        throw GarnerException("failed to allocate scheduler task");
+
+    task->slots.reserve(keys.size());
+    for (auto&& key : keys)
+        task->slots.push_back(std::hash<Garner::KType>{}(key) % NUM_SLOTS);
+    std::sort(task->slots.begin(), task->slots.end());
+    task->slots.erase(std::unique(task->slots.begin(), task->slots.end()),
+                      task->slots.end());
+
+    std::future<bool> future = task->promise.get_future();
+
+    std::lock_guard<std::mutex> lock(mtx);
+    if (stopping) {
+        delete task;
+        throw GarnerException("scheduler is shutting down");
+    }
+
+    unsigned target = Route(task);
+    workers[target]->queue.push_back(task);
+    if (workers[target]->idle)
+        workers[target]->cv.notify_one();
+    else if (Stealable(task))
+        WakeIdle(target);
+
+    return future;
+}
+
+}  // namespace garner
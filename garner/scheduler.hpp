@@ -0,0 +1,127 @@
+// TxnScheduler -- conflict-aware routing of transactions to worker threads.
+
+#include <condition_variable>
+#include <cstdint>
+#include <deque>
+#include <functional>
+#include <future>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+#include "include/garner.hpp"
+
+#pragma once
+
+namespace garner {
+
+/**
+ * Transaction scheduler running submitted transaction bodies on a pool of
+ * worker threads, each through Garner::RunTxn.
+ *
+ * Every transaction declares the keys it may access. Keys are hashed into a
+ * fixed number of conflict slots, and a slot with queued or running
+ * transactions is owned by the worker they were routed to. A new transaction
+ * goes to the worker owning most of its busy slots, so that likely
+ * conflicting transactions run one after another on the same worker instead
+ * of aborting each other; one touching no busy slot goes to the worker with
+ * the shortest queue.
+ *
+ * An idle worker steals from the back of other workers' queues, but only
+ * transactions none of whose slots is shared with any other pending
+ * transaction, so that stealing never splits up a conflicting group.
+ *
+ * Routing is only a hint: keys that a body accesses without declaring them
+ * are still handled correctly by concurrency control, and may just abort.
+ */
+class TxnScheduler {
+   public:
+    typedef std::function<void(TxnCxt<Garner::KType, Garner::VType>*)> TxnBody;
+
+   private:
+    // number of conflict slots keys are hashed into
+    static constexpr size_t NUM_SLOTS = 4096;
+
+    /** A submitted transaction waiting to run. */
+    struct Task {
+        TxnBody body;
+        RetryPolicy policy;
+        std::vector<size_t> slots;  // sorted and deduplicated
+        std::promise<bool> promise;
+    };
+
+    /** State of a conflict slot. */
+    struct Slot {
+        unsigned owner = 0;    // worker owning the slot if nactive > 0
+        unsigned nactive = 0;  // number of queued or running tasks in it
+    };
+
+    /** Per-worker queue, guarded by mtx. */
+    struct Worker {
+        std::deque<Task*> queue;
+        std::condition_variable cv;
+        bool idle = false;
+    };
+
+    // Garner instance transactions are run against
+    Garner* gn;
+
+    // one lock guards all slots and queues; it is held only briefly around
+    // routing and dequeueing, never while running a transaction
+    std::mutex mtx;
+    std::vector<Slot> slots;
+    std::vector<std::unique_ptr<Worker>> workers;
+    bool stopping = false;
+
+    std::vector<std::jthread> threads;
+
+    /**
+     * Pick the worker to enqueue a new task to and take its slots.
+     * Must hold mtx.
+     */
+    unsigned Route(const Task* task);
+
+    /**
+     * Returns true if the task shares none of its slots with other pending
+     * tasks, so it may move to another worker. Must hold mtx.
+     */
+    bool Stealable(const Task* task) const;
+
+    /**
+     * Take a task from another worker's queue for worker widx, handing its
+     * slots over. Returns nullptr if none can be stolen. Must hold mtx.
+     */
+    Task* Steal(unsigned widx);
+
+    /**
+     * Wake up one idle worker other than widx, if any. Must hold mtx.
+     */
+    void WakeIdle(unsigned widx);
+
+    /**
+     * Body of worker thread widx.
+     */
+    void WorkerLoop(unsigned widx);
+
+   public:
+    TxnScheduler(Garner* gn, unsigned nworkers);
+
+    TxnScheduler(const TxnScheduler&) = delete;
+    TxnScheduler& operator=(const TxnScheduler&) = delete;
+
+    /**
+     * Runs all transactions still queued, then joins the workers.
+     */
+    ~TxnScheduler();
+
+    /**
+     * Enqueue a transaction body with its declared key set. The returned
+     * future is set to RunTxn's result, or to the exception it threw.
+     */
+    std::future<bool> Submit(TxnBody body,
+                             const std::vector<Garner::KType>& keys,
+                             const RetryPolicy& policy);
+};
+
+}  // namespace garner
@@ -0,0 +1,116 @@
+// SmallMap -- small hash map with inline storage, used by transaction sets.
+
+#include <array>
+#include <cassert>
+#include <cstdint>
+#include <iostream>
+#include <type_traits>
+#include <utility>
+#include <vector>
+
+#pragma once
+
+namespace garner {
+
+/**
+ * Map from a pointer or integral key to a trivially-copyable value, tuned for
+ * the small read/write sets of typical transactions.
+ *
+ * Up to N entries are kept in an inline array and searched linearly, so a
+ * short transaction never touches the heap. Once the map outgrows the inline
+ * capacity, entries move into an open-addressing table with linear probing.
+ * Clear() keeps the table's capacity, so a recycled map does not allocate
+ * again in steady state.
+ *
+ * The default-constructed key (nullptr, or 0) is reserved as the empty-slot
+ * marker and must never be inserted.
+ */
+template <typename K, typename T, size_t N>
+class SmallMap {
+    static_assert(std::is_pointer_v<K> || std::is_integral_v<K>,
+                  "SmallMap key must be a pointer or integral type");
+    static_assert(N > 0, "SmallMap inline capacity must be positive");
+
+   private:
+    struct Entry {
+        K key;
+        T val;
+    };
+
+    // inline entries used while not spilled, packed in insertion order
+    std::array<Entry, N> inline_entries;
+
+    // open-addressing table used once spilled; size is always a power of 2
+    std::vector<Entry> table;
+
+    // number of valid entries
+    size_t nentries = 0;
+
+    // true if entries currently live in table instead of inline_entries
+    bool spilled = false;
+
+    /**
+     * Hash a key into a 64-bit value with multiplicative mixing.
+     */
+    static uint64_t HashKey(const K& key);
+
+    /**
+     * Find the slot index in table holding key, or the empty slot where it
+     * would be inserted.
+     */
+    size_t ProbeSlot(const K& key) const;
+
+    /**
+     * Move all entries into a table of the given size (power of 2).
+     */
+    void Rehash(size_t new_size);
+
+   public:
+    SmallMap() : inline_entries(), table(), nentries(0), spilled(false) {}
+
+    SmallMap(const SmallMap&) = delete;
+    SmallMap& operator=(const SmallMap&) = delete;
+
+    ~SmallMap() = default;
+
+    /**
+     * Number of entries in map.
+     */
+    size_t Size() const { return nentries; }
+    bool Empty() const { return nentries == 0; }
+
+    /**
+     * Returns a pointer to the value mapped by key, or nullptr if not found.
+     * The pointer is invalidated by any subsequent Insert or Erase.
+     */
+    T* Find(const K& key);
+    const T* Find(const K& key) const;
+
+    bool Contains(const K& key) const { return Find(key) != nullptr; }
+
+    /**
+     * Insert key -> val, overwriting the old value if key already exists.
+     */
+    void Insert(const K& key, T val);
+
+    /**
+     * Erase key from map. Returns true if key was found.
+     */
+    bool Erase(const K& key);
+
+    /**
+     * Remove all entries while keeping the allocated table capacity.
+     */
+    void Clear();
+
+    /**
+     * Apply func(key, val) to every entry, in unspecified order.
+     */
+    template <typename Func>
+    void ForEach(Func func) const;
+};
+
+}  // namespace garner
+
+// Include template implementation in-place.
+#include "small_map.tpl.hpp"
@@ -0,0 +1,168 @@
+// Template implementation included in-place by the ".hpp".
+
+#pragma once
+
+namespace garner {
+
+template <typename K, typename T, size_t N>
+uint64_t SmallMap<K, T, N>::HashKey(const K& key) {
+    uint64_t raw;
+    if constexpr (std::is_pointer_v<K>)
+        raw = reinterpret_cast<uint64_t>(key);
+    else
+        raw = static_cast<uint64_t>(key);
+
+    // Fibonacci hashing; the high bits are well mixed, so fold them down
+    // as table sizes are small powers of 2
+    uint64_t hash = raw * 0x9E3779B97F4A7C15ULL;
+    return hash ^ (hash >> 32);
+}
+
+template <typename K, typename T, size_t N>
+size_t SmallMap<K, T, N>::ProbeSlot(const K& key) const {
+    assert(spilled);
+    assert(table.size() > 0 && (table.size() & (table.size() - 1)) == 0);
+    size_t mask = table.size() - 1;
+    size_t slot = HashKey(key) & mask;
+    while (table[slot].key != K{} && table[slot].key != key)
+        slot = (slot + 1) & mask;
+    return slot;
+}
+
+template <typename K, typename T, size_t N>
+void SmallMap<K, T, N>::Rehash(size_t new_size) {
+    assert((new_size & (new_size - 1)) == 0);
+
+    if (!spilled) {
+        // first spill out of inline storage; reuse a previously allocated
+        // table if it is large enough (it was emptied by Clear)
+        if (table.size() < new_size) table.assign(new_size, Entry{K{}, T{}});
+        spilled = true;
+        for (size_t i = 0; i < nentries; ++i) {
+            size_t slot = ProbeSlot(inline_entries[i].key);
+            table[slot] = inline_entries[i];
+        }
+    } else {
+        // grow existing table
+        std::vector<Entry> old_table(new_size, Entry{K{}, T{}});
+        table.swap(old_table);
+        for (auto&& entry : old_table) {
+            if (entry.key == K{}) continue;
+            size_t slot = ProbeSlot(entry.key);
+            table[slot] = entry;
+        }
+    }
+}
+
+template <typename K, typename T, size_t N>
+T* SmallMap<K, T, N>::Find(const K& key) {
+    return const_cast<T*>(std::as_const(*this).Find(key));
+}
+
+template <typename K, typename T, size_t N>
+const T* SmallMap<K, T, N>::Find(const K& key) const {
+    assert(key != K{});
+    if (!spilled) {
+        for (size_t i = 0; i < nentries; ++i)
+            if (inline_entries[i].key == key) return &inline_entries[i].val;
+        return nullptr;
+    }
+
+    size_t slot = ProbeSlot(key);
+    if (table[slot].key == K{}) return nullptr;
+    return &table[slot].val;
+}
+
+template <typename K, typename T, size_t N>
+void SmallMap<K, T, N>::Insert(const K& key, T val) {
+    assert(key != K{});
+    if (!spilled) {
+        for (size_t i = 0; i < nentries; ++i) {
+            if (inline_entries[i].key == key) {
+                inline_entries[i].val = val;
+                return;
+            }
+        }
+        if (nentries < N) {
+            inline_entries[nentries++] = Entry{key, val};
+            return;
+        }
+        // inline storage full, spill into a table with load factor <= 1/4
+        size_t new_size = 1;
+        while (new_size < 4 * N) new_size <<= 1;
+        Rehash(new_size);
+    }
+
+    size_t slot = ProbeSlot(key);
+    if (table[slot].key == key) {
+        table[slot].val = val;
+        return;
+    }
+
+    // keep load factor <= 1/2 for short probe sequences
+    if (2 * (nentries + 1) > table.size()) {
+        Rehash(2 * table.size());
+        slot = ProbeSlot(key);
+    }
+    table[slot] = Entry{key, val};
+    nentries++;
+}
+
+template <typename K, typename T, size_t N>
+bool SmallMap<K, T, N>::Erase(const K& key) {
+    assert(key != K{});
+    if (!spilled) {
+        for (size_t i = 0; i < nentries; ++i) {
+            if (inline_entries[i].key == key) {
+                inline_entries[i] = inline_entries[nentries - 1];
+                nentries--;
+                return true;
+            }
+        }
+        return false;
+    }
+
+    size_t slot = ProbeSlot(key);
+    if (table[slot].key == K{}) return false;
+
+    // backward-shift deletion: pull later entries of the probe chain into
+    // the hole so that lookups never need tombstones
+    size_t mask = table.size() - 1;
+    size_t hole = slot;
+    size_t next = (hole + 1) & mask;
+    while (table[next].key != K{}) {
+        size_t home = HashKey(table[next].key) & mask;
+        // move entry at next into hole if its home is not in (hole, next]
+        if (((next - home) & mask) >= ((next - hole) & mask)) {
+            table[hole] = table[next];
+            hole = next;
+        }
+        next = (next + 1) & mask;
+    }
+    table[hole] = Entry{K{}, T{}};
+    nentries--;
+    return true;
+}
+
+template <typename K, typename T, size_t N>
+void SmallMap<K, T, N>::Clear() {
+    if (spilled) {
+        for (auto&& entry : table) entry.key = K{};
+        spilled = false;
+    }
+    nentries = 0;
+}
+
+template <typename K, typename T, size_t N>
+template <typename Func>
+void SmallMap<K, T, N>::ForEach(Func func) const {
+    if (!spilled) {
+        for (size_t i = 0; i < nentries; ++i)
+            func(inline_entries[i].key, inline_entries[i].val);
+    } else {
+        for (auto&& entry : table)
+            if (entry.key != K{}) func(entry.key, entry.val);
+    }
+}
+
+}  // namespace garner
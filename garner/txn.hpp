@@ -2,8 +2,11 @@
 
 #include <atomic>
 #include <chrono>
+#include <functional>
 #include <iostream>
+#include <vector>
 
+#include "include/garner.hpp"
 #include "record.hpp"
 
 #pragma once
@@ -15,7 +18,15 @@ namespace garner {
  */
 template <typename K, typename V>
 class TxnCxt {
+   private:
+    // phantom records pinned on behalf of the transaction, see Record
+    std::vector<Record<K, V>*> pinned;
+
    public:
+    // read-modify-write function of an Update, given the current value and
+    // whether it exists
+    typedef std::function<V(const V&, bool)> UpdateFn;
+
     // a transaction starts upon the construction of a TxnCxt
     TxnCxt() = default;
 
@@ -24,6 +35,30 @@ class TxnCxt {
 
     virtual ~TxnCxt() = default;
 
+    /**
+     * Clear all per-transaction state so that the context can be recycled
+     * for a new transaction. Containers should keep their capacity.
+     */
+    virtual void Reset() = 0;
+
+    /**
+     * Pin a phantom record handed out by the tree until the transaction
+     * finishes. Must be called under the latch of the record's leaf.
+     */
+    void PinPhantom(Record<K, V>* record) {
+        record->Pin();
+        pinned.push_back(record);
+    }
+
+    /**
+     * Hand all pinned records over to the caller, who is to unpin them once
+     * the transaction has finished.
+     */
+    void TakePinned(std::vector<Record<K, V>*>& records) {
+        records.swap(pinned);
+        pinned.clear();
+    }
+
     /**
      * Called upon a specific operation type within a transaction.
      * Concurrency control sub-types should implement these methods.
@@ -32,6 +67,10 @@ class TxnCxt {
     virtual void ExecWriteRecord(Record<K, V>* record, V value) = 0;
     virtual void ExecReadTraverseNode(Page<K>* page) = 0;
     virtual void ExecWriteTraverseNode(Page<K>* page, unsigned height) = 0;
+    virtual void ExecObserveLeaf(Page<K>* leaf) = 0;
+    virtual void ExecInsertIntoLeaf(Page<K>* leaf, uint64_t old_node_ver,
+                                    Page<K>* split_lpage,
+                                    Page<K>* split_rpage) = 0;
     virtual void ExecEnterPut() = 0;
     virtual void ExecLeavePut() = 0;
     virtual void ExecEnterGet() = 0;
@@ -41,6 +80,45 @@ class TxnCxt {
     virtual void ExecEnterScan() = 0;
     virtual void ExecLeaveScan() = 0;
 
+    /**
+     * Called upon an Update. By default, reads the record and writes back
+     * fn's result; protocols that can repair a stale read at commit time
+     * keep fn around to re-run it instead.
+     */
+    virtual void ExecUpdateRecord(Record<K, V>* record, const UpdateFn& fn) {
+        V value;
+        bool found = ExecReadRecord(record, value);
+        if (IsDoomed()) return;
+        ExecWriteRecord(record, fn(value, found));
+    }
+
+    /**
+     * Called upon a Merge, whose value is not observed by the transaction.
+     * By default, treated as an Update; protocols that validate reads may
+     * instead apply fn at commit time without reading the record.
+     */
+    virtual void ExecMergeRecord(Record<K, V>* record, const UpdateFn& fn) {
+        ExecUpdateRecord(record, fn);
+    }
+
+    /**
+     * Returns true if an abort decision has already been made during
+     * execution, in which case further operations are pointless.
+     */
+    virtual bool IsDoomed() const = 0;
+
+    /**
+     * Returns the access mode the transaction was started in. Write
+     * operations must only be issued through TXN_READ_WRITE transactions.
+     */
+    virtual TxnMode Mode() const = 0;
+
+    /**
+     * Returns the isolation level the transaction runs at. Contexts that
+     * implement weaker levels override this.
+     */
+    virtual TxnIsolation Isolation() const { return ISOLATION_SERIALIZABLE; }
+
     /**
      * Validate upon transaction commit. If can commit, reflect its effect to
      * the database; otherwise, must abort.
@@ -0,0 +1,191 @@
+// Txn2PL -- pessimistic two-phase locking protocol.
+
+#include <atomic>
+#include <iostream>
+#include <thread>
+#include <vector>
+
+#include "build_options.hpp"
+#include "common.hpp"
+#include "epoch.hpp"
+#include "node_set.hpp"
+#include "page.hpp"
+#include "record.hpp"
+#include "small_map.hpp"
+#include "txn.hpp"
+
+#pragma once
+
+namespace garner {
+
+/**
+ * Strict two-phase locking transaction context type. Records are locked
+ * shared on read and exclusive on write at access time, and all locks are
+ * held until commit or abort. Writes are buffered and installed at commit
+ * with a new TID, so that read-only and snapshot transactions work the same
+ * as under OCC. Phantoms are caught by validating leaf node versions at
+ * commit, as in Silo.
+ *
+ * Deadlocks are avoided with one of the two classic policies:
+ *   - NO_WAIT: abort upon any lock conflict
+ *   - WAIT_DIE: an older transaction waits for a younger holder, a younger
+ *     one aborts; the timestamp is drawn at the first lock request
+ * Reads issued by Scan hold the leaf's page latch, so conflicts there abort
+ * under both policies rather than waiting behind the latch.
+ */
+template <typename K, typename V>
+class Txn2PL : public TxnCxt<K, V> {
+   private:
+    // source of wait-die timestamps, smaller means older
+    static std::atomic<uint64_t> ts_counter;
+
+    // lock list storing record -> lock mode
+    struct LockListItem {
+        Record<K, V>* record;
+        bool exclusive;
+    };
+
+    std::vector<LockListItem> lock_vec;
+
+    // lock set storing record -> index in lock_vec
+    SmallMap<Record<K, V>*, size_t, 16> lock_set;
+
+    // write list storing record -> new value
+    struct WriteListItem {
+        Record<K, V>* record;
+        V value;
+    };
+
+    std::vector<WriteListItem> write_vec;
+
+    // write set storing record -> index in write_vec
+    SmallMap<Record<K, V>*, size_t, 16> write_set;
+
+    // leaf node versions observed by negative lookups and scans, for
+    // detecting phantoms
+    NodeSet<K> node_set;
+
+    // phantom records read as absent without being locked; they must still
+    // be unfilled at commit
+    std::vector<Record<K, V>*> phantom_vec;
+
+    // true if waiting on conflicts as in WAIT_DIE, otherwise NO_WAIT
+    const bool wait_die = false;
+
+    // my wait-die timestamp, 0 if not drawn yet
+    uint64_t ts = 0;
+
+    // true while inside a Scan, i.e., holding a leaf page latch on reads
+    bool in_scan = false;
+
+    // true if abort decision already made during execution
+    bool must_abort = false;
+
+    /**
+     * Acquire the record lock in given mode, or upgrade to exclusive if held
+     * shared. Returns false if must abort due to a conflict.
+     */
+    bool AcquireLock(Record<K, V>* record, bool exclusive);
+
+    /**
+     * Release all held record locks.
+     */
+    void ReleaseLocks();
+
+   public:
+    Txn2PL(bool wait_die)
+        : TxnCxt<K, V>(),
+          lock_vec(),
+          lock_set(),
+          write_vec(),
+          write_set(),
+          node_set(),
+          phantom_vec(),
+          wait_die(wait_die),
+          ts(0),
+          in_scan(false),
+          must_abort(false) {}
+
+    Txn2PL(const Txn2PL&) = delete;
+    Txn2PL& operator=(const Txn2PL&) = delete;
+
+    ~Txn2PL() { ReleaseLocks(); }
+
+    /**
+     * Release locks and clear all sets for recycling.
+     */
+    void Reset();
+
+    /**
+     * Lock record shared and set value to its current value. Returns true
+     * if read is successful, or false if reading a phantom record inserted
+     * by some other transaction without filled value, or if the lock could
+     * not be acquired, in which case the transaction is doomed.
+     */
+    bool ExecReadRecord(Record<K, V>* record, V& value);
+
+    /**
+     * Lock record exclusive and locally remember attempted write value.
+     */
+    void ExecWriteRecord(Record<K, V>* record, V value);
+
+    /**
+     * Save leaf to node set with its current node version.
+     */
+    void ExecObserveLeaf(Page<K>* leaf);
+
+    /**
+     * Follow node version bumps caused by my own insertion into leaf, which
+     * may have split it, in which case the new leaf pages are given.
+     */
+    void ExecInsertIntoLeaf(Page<K>* leaf, uint64_t old_node_ver,
+                            Page<K>* split_lpage, Page<K>* split_rpage);
+
+    /**
+     * Track whether reads are issued under a leaf page latch.
+     */
+    void ExecEnterScan() { in_scan = true; }
+    void ExecLeaveScan() { in_scan = false; }
+
+    /**
+     * Not used.
+     */
+    void ExecReadTraverseNode([[maybe_unused]] Page<K>* page) {}
+    void ExecWriteTraverseNode([[maybe_unused]] Page<K>* page,
+                               [[maybe_unused]] unsigned height) {}
+    void ExecEnterPut() {}
+    void ExecLeavePut() {}
+    void ExecEnterGet() {}
+    void ExecLeaveGet() {}
+    void ExecEnterDelete() {}
+    void ExecLeaveDelete() {}
+
+    bool IsDoomed() const { return must_abort; }
+    TxnMode Mode() const { return TXN_READ_WRITE; }
+
+    /**
+     * Check for phantoms, install buffered writes, and release all locks.
+     */
+    bool TryCommit(std::atomic<uint64_t>* ser_counter = nullptr,
+                   uint64_t* ser_order = nullptr, TxnStats* stats = nullptr);
+
+    template <typename KK, typename VV>
+    friend std::ostream& operator<<(std::ostream& s,
+                                    const Txn2PL<KK, VV>& txn);
+};
+
+template <typename K, typename V>
+std::ostream& operator<<(std::ostream& s, const Txn2PL<K, V>& txn) {
+    s << "Txn2PL{ts=" << txn.ts << ",lock_vec=[";
+    for (auto&& [r, excl] : txn.lock_vec)
+        s << "(" << r << "-" << (excl ? "X" : "S") << "),";
+    s << "],write_set=[";
+    for (auto&& [r, val] : txn.write_vec) s << "(" << r << "-" << val << "),";
+    s << "],must_abort=" << txn.must_abort << "}";
+    return s;
+}
+
+}  // namespace garner
+
+// Include template implementation in-place.
+#include "txn_2pl.tpl.hpp"
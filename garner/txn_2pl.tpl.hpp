@@ -0,0 +1,230 @@
+// Template implementation included in-place by the ".hpp".
+
+#pragma once
+
+namespace garner {
+
+template <typename K, typename V>
+std::atomic<uint64_t> Txn2PL<K, V>::ts_counter(1);
+
+template <typename K, typename V>
+void Txn2PL<K, V>::Reset() {
+    ReleaseLocks();
+    write_vec.clear();
+    write_set.Clear();
+    node_set.Clear();
+    phantom_vec.clear();
+    ts = 0;
+    in_scan = false;
+    must_abort = false;
+}
+
+template <typename K, typename V>
+void Txn2PL<K, V>::ReleaseLocks() {
+    for (auto&& [record, exclusive] : lock_vec) {
+        record->Unlock2PL(exclusive);
+        DEBUG("record lock %s release %p", exclusive ? "X" : "S",
+              static_cast<void*>(record));
+    }
+    lock_vec.clear();
+    lock_set.Clear();
+}
+
+template <typename K, typename V>
+bool Txn2PL<K, V>::AcquireLock(Record<K, V>* record, bool exclusive) {
+    size_t* lock_idx = lock_set.Find(record);
+    bool upgrade = false;
+    if (lock_idx != nullptr) {
+        assert(*lock_idx < lock_vec.size());
+        if (lock_vec[*lock_idx].exclusive || !exclusive) return true;
+        upgrade = true;
+    }
+
+    // timestamps are drawn lazily, so that a transaction's age counts from
+    // its first possible conflict
+    if (ts == 0) ts = ts_counter.fetch_add(1, std::memory_order_relaxed);
+
+    while (true) {
+        uint64_t holder_ts;
+        if (record->TryLock2PL(exclusive, upgrade, ts, holder_ts)) break;
+
+        // NO_WAIT, or the holder could be waiting on the page latch I hold,
+        // or wait-die says I am younger: die
+        // on an upgrade, the holders' bound covers myself, so of two
+        // upgraders only the oldest may wait
+        if (!wait_die || in_scan || ts > holder_ts) {
+            must_abort = true;
+            return false;
+        }
+        std::this_thread::yield();
+    }
+    DEBUG("record lock %s acquire %p", exclusive ? "X" : "S",
+          static_cast<void*>(record));
+
+    if (upgrade)
+        lock_vec[*lock_idx].exclusive = true;
+    else {
+        lock_vec.push_back(
+            LockListItem{.record = record, .exclusive = exclusive});
+        lock_set.Insert(record, lock_vec.size() - 1);
+    }
+    return true;
+}
+
+template <typename K, typename V>
+bool Txn2PL<K, V>::ExecReadRecord(Record<K, V>* record, V& value) {
+    if (must_abort) return false;
+
+    // if in my local write set, read from there instead
+    const size_t* write_idx = write_set.Find(record);
+    if (write_idx != nullptr) {
+        assert(*write_idx < write_vec.size());
+        value = write_vec[*write_idx].value;
+        return true;
+    }
+
+    // a phantom record without filled value is not locked, so as not to
+    // block its inserter; a phantom insertion is caught by the node set, and
+    // the record getting filled by the check at commit
+    if (!lock_set.Contains(record) &&
+        !Record<K, V>::TidValid(record->LoadTid())) {
+        phantom_vec.push_back(record);
+        return false;
+    }
+
+    if (!AcquireLock(record, false)) return false;
+
+    // the TID word may still be locked by a committing writer that has just
+    // released its 2PL lock; the consistent read waits it out
+    uint64_t read_tid = record->ReadConsistent(value);
+    return Record<K, V>::TidValid(read_tid);
+}
+
+template <typename K, typename V>
+void Txn2PL<K, V>::ExecWriteRecord(Record<K, V>* record, V value) {
+    if (must_abort) return;
+    if (!AcquireLock(record, true)) return;
+
+    // do not actually write; save value locally
+    size_t* write_idx = write_set.Find(record);
+    if (write_idx != nullptr) {
+        assert(*write_idx < write_vec.size());
+        write_vec[*write_idx].value = std::move(value);
+    } else {
+        write_vec.push_back(
+            WriteListItem{.record = record, .value = std::move(value)});
+        write_set.Insert(record, write_vec.size() - 1);
+    }
+}
+
+template <typename K, typename V>
+void Txn2PL<K, V>::ExecObserveLeaf(Page<K>* leaf) {
+    // leaf got a new key or split since I first observed it
+    if (!node_set.Observe(leaf)) must_abort = true;
+}
+
+template <typename K, typename V>
+void Txn2PL<K, V>::ExecInsertIntoLeaf(Page<K>* leaf, uint64_t old_node_ver,
+                                      Page<K>* split_lpage,
+                                      Page<K>* split_rpage) {
+    node_set.Inserted(leaf, old_node_ver, split_lpage, split_rpage);
+}
+
+template <typename K, typename V>
+bool Txn2PL<K, V>::TryCommit(std::atomic<uint64_t>* ser_counter,
+                             uint64_t* ser_order, TxnStats* stats) {
+    if (must_abort) {
+        ReleaseLocks();
+        return false;
+    }
+
+    std::chrono::time_point<std::chrono::high_resolution_clock> start_tp;
+    if constexpr (build_options.txn_stat)
+        start_tp = std::chrono::high_resolution_clock::now();
+
+    // lock TID words of written records for installing; exclusive 2PL locks
+    // are held on all of them, so no ordering is needed
+    for (auto&& [record, _] : write_vec) {
+        record->Lock();
+        DEBUG("record latch W acquire %p", static_cast<void*>(record));
+    }
+
+    std::chrono::time_point<std::chrono::high_resolution_clock> end_lock_tp;
+    if constexpr (build_options.txn_stat)
+        end_lock_tp = std::chrono::high_resolution_clock::now();
+
+    // stay in an epoch critical section until all writes are installed, for
+    // snapshot reads
+    EpochGuard epoch_guard;
+
+    // <-- serialization point -->
+    // all record locks are held at this point
+    if (ser_counter != nullptr && ser_order != nullptr)
+        *ser_order = (*ser_counter)++;
+
+    uint64_t new_version = EpochManager::Global().NewCommitTid();
+
+    auto release_all_locks = [&]() {
+        for (auto&& [record, _] : write_vec) {
+            record->Unlock();
+            DEBUG("record latch W release %p", static_cast<void*>(record));
+        }
+        ReleaseLocks();
+    };
+
+    // if any observed leaf got new keys or split, abort due to phantoms
+    if (!node_set.Validate()) {
+        release_all_locks();
+        return false;
+    }
+
+    // if any phantom record read as absent got filled, or is being filled,
+    // by someone else, abort; those I write are exclusively locked by me
+    for (auto* record : phantom_vec) {
+        if (write_set.Contains(record)) continue;
+        uint64_t curr_tid = record->LoadTid();
+        if (Record<K, V>::TidValid(curr_tid) ||
+            Record<K, V>::TidLocked(curr_tid)) {
+            release_all_locks();
+            return false;
+        }
+    }
+
+    std::chrono::time_point<std::chrono::high_resolution_clock> end_validate_tp;
+    if constexpr (build_options.txn_stat)
+        end_validate_tp = std::chrono::high_resolution_clock::now();
+
+    // reflect writes with new version number, then release all locks
+    for (auto&& [record, value] : write_vec) {
+        record->InstallValue(std::move(value), new_version);
+        record->UnlockWithVersion(new_version);
+        DEBUG("record latch W release %p", static_cast<void*>(record));
+    }
+    ReleaseLocks();
+
+    std::chrono::time_point<std::chrono::high_resolution_clock> end_commit_tp;
+    if constexpr (build_options.txn_stat)
+        end_commit_tp = std::chrono::high_resolution_clock::now();
+
+    // record latency breakdown in microseconds
+    if constexpr (build_options.txn_stat) {
+        if (stats != nullptr) {
+            stats->lock_time =
+                std::chrono::duration_cast<std::chrono::microseconds>(
+                    end_lock_tp - start_tp)
+                    .count();
+            stats->validate_time =
+                std::chrono::duration_cast<std::chrono::microseconds>(
+                    end_validate_tp - end_lock_tp)
+                    .count();
+            stats->commit_time =
+                std::chrono::duration_cast<std::chrono::microseconds>(
+                    end_commit_tp - end_validate_tp)
+                    .count();
+        }
+    }
+
+    return true;
+}
+
+}  // namespace garner
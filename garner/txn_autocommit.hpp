@@ -0,0 +1,146 @@
+// TxnAutocommit -- lightweight context for single-operation transactions.
+
+#include <algorithm>
+#include <atomic>
+#include <iostream>
+#include <thread>
+#include <vector>
+
+#include "build_options.hpp"
+#include "common.hpp"
+#include "epoch.hpp"
+#include "page.hpp"
+#include "record.hpp"
+#include "txn.hpp"
+#include "txn_tictoc.hpp"
+
+#pragma once
+
+namespace garner {
+
+/**
+ * Autocommit context used for implicit single-key Get and Put operations
+ * (i.e., called with txn == nullptr) under OCC protocols.
+ *
+ * A single Get is serializable by itself as long as it reads a consistent
+ * (value, version) pair of the record, so no read set is kept and nothing
+ * is validated. A blind Put installs its value with a new version directly
+ * under the record's TID lock. Under hierarchical validation, the
+ * write-traversed pages still get their hv_sem held across the install and
+ * their hv_ver bumped, so that concurrent HV readers notice the change.
+ * Under 2PL, the write also takes the record's exclusive 2PL lock around
+ * the install, waiting for any holder, which is safe since no other lock is
+ * held. Under TicToc, the write locks the record's timestamp word and
+ * commits after the current version's rts, the rts of a leaf it inserted
+ * into, and the thread's last TicToc commit.
+ */
+template <typename K, typename V>
+class TxnAutocommit : public TxnCxt<K, V> {
+   private:
+    // pages traversed in write mode, in root-to-leaf order
+    std::vector<Page<K>*> write_pages;
+
+    // true if should maintain hierarchical validation info on pages
+    const bool track_hv = false;
+
+    // pages higher than this are left out of hierarchical validation, 0 means
+    // no cutoff
+    const unsigned hv_max_height = 0;
+
+    // true if should respect 2PL record locks held by transactions
+    const bool lock_2pl = false;
+
+    // true if should maintain TicToc timestamps, and the lower bound of
+    // commit timestamp imposed by a leaf inserted into
+    const bool tictoc = false;
+    uint64_t tictoc_min_ts = 0;
+
+   public:
+    TxnAutocommit(bool track_hv, unsigned hv_max_height = 0,
+                  bool lock_2pl = false, bool tictoc = false)
+        : TxnCxt<K, V>(),
+          write_pages(),
+          track_hv(track_hv),
+          hv_max_height(hv_max_height),
+          lock_2pl(lock_2pl),
+          tictoc(tictoc),
+          tictoc_min_ts(0) {}
+
+    TxnAutocommit(const TxnAutocommit&) = delete;
+    TxnAutocommit& operator=(const TxnAutocommit&) = delete;
+
+    ~TxnAutocommit() = default;
+
+    /**
+     * Clear traversed pages list for recycling.
+     */
+    void Reset();
+
+    /**
+     * Read a consistent value of record. Returns false if reading a phantom
+     * record inserted by some other transaction without filled value.
+     */
+    bool ExecReadRecord(Record<K, V>* record, V& value);
+
+    /**
+     * Install the write immediately with a new version number.
+     */
+    void ExecWriteRecord(Record<K, V>* record, V value);
+
+    /**
+     * If tracking HV, hold the page's hv_sem until the write is installed.
+     */
+    void ExecWriteTraverseNode(Page<K>* page, unsigned height);
+
+    /**
+     * If TicToc, commit after those who observed the leaf's key range.
+     */
+    void ExecInsertIntoLeaf(Page<K>* leaf,
+                            [[maybe_unused]] uint64_t old_node_ver,
+                            Page<K>* split_lpage, Page<K>* split_rpage);
+
+    /**
+     * Not used.
+     */
+    void ExecReadTraverseNode([[maybe_unused]] Page<K>* page) {}
+    void ExecObserveLeaf([[maybe_unused]] Page<K>* leaf) {}
+    void ExecEnterPut() {}
+    void ExecLeavePut() {}
+    void ExecEnterGet() {}
+    void ExecLeaveGet() {}
+    void ExecEnterDelete() {}
+    void ExecLeaveDelete() {}
+    void ExecEnterScan() {}
+    void ExecLeaveScan() {}
+
+    /**
+     * Never doomed since nothing is validated.
+     */
+    bool IsDoomed() const { return false; }
+    TxnMode Mode() const { return TXN_READ_WRITE; }
+
+    /**
+     * Effects are already reflected during execution; always commits.
+     */
+    bool TryCommit(std::atomic<uint64_t>* ser_counter = nullptr,
+                   uint64_t* ser_order = nullptr, TxnStats* stats = nullptr);
+
+    template <typename KK, typename VV>
+    friend std::ostream& operator<<(std::ostream& s,
+                                    const TxnAutocommit<KK, VV>& txn);
+};
+
+template <typename K, typename V>
+std::ostream& operator<<(std::ostream& s, const TxnAutocommit<K, V>& txn) {
+    s << "TxnAutocommit{write_pages=[";
+    for (auto* page : txn.write_pages) s << page << ",";
+    s << "],track_hv=" << txn.track_hv
+      << ",hv_max_height=" << txn.hv_max_height
+      << ",lock_2pl=" << txn.lock_2pl << ",tictoc=" << txn.tictoc << "}";
+    return s;
+}
+
+}  // namespace garner
+
+// Include template implementation in-place.
+#include "txn_autocommit.tpl.hpp"
@@ -0,0 +1,106 @@
+// Template implementation included in-place by the ".hpp".
+
+#pragma once
+
+namespace garner {
+
+template <typename K, typename V>
+void TxnAutocommit<K, V>::Reset() {
+    write_pages.clear();
+    tictoc_min_ts = 0;
+}
+
+template <typename K, typename V>
+bool TxnAutocommit<K, V>::ExecReadRecord(Record<K, V>* record, V& value) {
+    uint64_t tid = record->ReadConsistent(value);
+    return Record<K, V>::TidValid(tid);
+}
+
+template <typename K, typename V>
+void TxnAutocommit<K, V>::ExecWriteTraverseNode(Page<K>* page,
+                                                unsigned height) {
+    if (!track_hv) return;
+    if (hv_max_height > 0 && height > hv_max_height) return;
+
+    // a page may show up twice if a split changed the path
+    if (std::find(write_pages.begin(), write_pages.end(), page) !=
+        write_pages.end())
+        return;
+
+    page->HoldHVSem();
+    DEBUG("page hv_sem increment %p", static_cast<void*>(page));
+    write_pages.push_back(page);
+}
+
+template <typename K, typename V>
+void TxnAutocommit<K, V>::ExecInsertIntoLeaf(
+    Page<K>* leaf, [[maybe_unused]] uint64_t old_node_ver,
+    Page<K>* split_lpage, Page<K>* split_rpage) {
+    if (!tictoc) return;
+
+    // pairs with the fence in TicToc commit, see TxnTicToc
+    std::atomic_thread_fence(std::memory_order_seq_cst);
+    for (Page<K>* page : {leaf, split_lpage, split_rpage}) {
+        if (page == nullptr) continue;
+        tictoc_min_ts =
+            std::max(tictoc_min_ts,
+                     page->tictoc_rts.load(std::memory_order_relaxed) + 1);
+    }
+}
+
+template <typename K, typename V>
+void TxnAutocommit<K, V>::ExecWriteRecord(Record<K, V>* record, V value) {
+    if (lock_2pl) {
+        uint64_t holder_ts;
+        while (!record->TryLock2PL(true, false, UINT64_MAX, holder_ts))
+            std::this_thread::yield();
+    }
+
+    uint64_t commit_ts = 0;
+    if (tictoc) {
+        uint64_t word = record->LockTicToc();
+        commit_ts = std::max({tictoc_min_ts, Record<K, V>::TicTocRts(word) + 1,
+                              TxnTicToc<K, V>::ThreadLastCommitTs()});
+    }
+
+    record->Lock();
+    DEBUG("record latch W acquire %p", static_cast<void*>(record));
+
+    // keep global epoch from moving two past my commit TID's epoch until
+    // the write is installed, for snapshot reads
+    EpochGuard epoch_guard;
+
+    // <-- serialization point -->
+    uint64_t new_version = EpochManager::Global().NewCommitTid();
+
+    record->InstallValue(std::move(value), new_version);
+    record->UnlockWithVersion(new_version);
+    DEBUG("record latch W release %p", static_cast<void*>(record));
+
+    if (tictoc) {
+        record->UnlockTicTocWithTs(commit_ts);
+        TxnTicToc<K, V>::ThreadLastCommitTs() = commit_ts;
+    }
+    if (lock_2pl) record->Unlock2PL(true);
+
+    for (auto* page : write_pages) {
+        page->hv_ver = new_version;
+        page->ReleaseHVSem();
+        DEBUG("page hv_sem decrement %p", static_cast<void*>(page));
+    }
+    write_pages.clear();
+}
+
+template <typename K, typename V>
+bool TxnAutocommit<K, V>::TryCommit(std::atomic<uint64_t>* ser_counter,
+                                    uint64_t* ser_order,
+                                    [[maybe_unused]] TxnStats* stats) {
+    // <-- serialization point -->
+    // the operation itself has already taken effect atomically
+    if (ser_counter != nullptr && ser_order != nullptr)
+        *ser_order = (*ser_counter)++;
+
+    return true;
+}
+
+}  // namespace garner
@@ -0,0 +1,154 @@
+// TxnReadOnly -- context for transactions declared read-only upfront.
+
+#include <atomic>
+#include <chrono>
+#include <iostream>
+#include <thread>
+#include <vector>
+
+#include "build_options.hpp"
+#include "common.hpp"
+#include "node_set.hpp"
+#include "page.hpp"
+#include "record.hpp"
+#include "small_map.hpp"
+#include "txn.hpp"
+
+#pragma once
+
+namespace garner {
+
+/**
+ * Read-only transaction context type, usable under any OCC protocol.
+ *
+ * Keeps only a read set and a node set; there is no write set and nothing
+ * to lock at commit time. Commit is a single snapshot-consistency check:
+ * every record read must still carry the version read, and every observed
+ * leaf must have had no new keys. If so, the committed database state at
+ * the start of the check is exactly what the transaction has seen, so it
+ * serializes there. A record locked by an in-flight writer is waited on
+ * rather than treated as a conflict, since the writer may well release it
+ * unchanged; so only writers that actually overwrite something read can
+ * abort a read-only transaction.
+ */
+template <typename K, typename V>
+class TxnReadOnly : public TxnCxt<K, V> {
+   private:
+    // read list storing record -> read version
+    struct RecordListItem {
+        Record<K, V>* record;
+        uint64_t version;
+    };
+
+    std::vector<RecordListItem> read_vec;
+
+    // read set storing record -> index in read_vec
+    SmallMap<Record<K, V>*, size_t, 16> read_set;
+
+    // leaf node versions observed by negative lookups and scans, for
+    // detecting phantoms
+    NodeSet<K> node_set;
+
+    // true if abort decision already made during execution
+    bool must_abort = false;
+
+    // index into read_vec of the next earlier read to re-check
+    size_t recheck_idx = 0;
+
+    /**
+     * Re-check the version of one earlier read per operation in round-robin
+     * order, catching a doomed transaction early at O(1) cost.
+     */
+    void RecheckOneRead();
+
+    // set true to skip the commit-time check, matching PROTOCOL_SILO_NR
+    const bool no_read_validation = false;
+
+   public:
+    TxnReadOnly(bool no_read_validation = false)
+        : TxnCxt<K, V>(),
+          read_vec(),
+          read_set(),
+          node_set(),
+          must_abort(false),
+          recheck_idx(0),
+          no_read_validation(no_read_validation) {}
+
+    TxnReadOnly(const TxnReadOnly&) = delete;
+    TxnReadOnly& operator=(const TxnReadOnly&) = delete;
+
+    ~TxnReadOnly() = default;
+
+    /**
+     * Clear read and node sets for recycling, keeping their capacity.
+     */
+    void Reset();
+
+    /**
+     * Save record to read set, set value to its current read value.
+     * Returns true if read is successful, or false if reading a phantom
+     * record inserted by some other transaction without filled value.
+     */
+    bool ExecReadRecord(Record<K, V>* record, V& value);
+
+    /**
+     * Never called, since GarnerImpl rejects writes in read-only
+     * transactions before touching the tree.
+     */
+    void ExecWriteRecord(Record<K, V>* record, V value);
+
+    /**
+     * Save leaf to node set with its current node version.
+     */
+    void ExecObserveLeaf(Page<K>* leaf);
+
+    /**
+     * Not used.
+     */
+    void ExecReadTraverseNode([[maybe_unused]] Page<K>* page) {}
+    void ExecWriteTraverseNode([[maybe_unused]] Page<K>* page,
+                               [[maybe_unused]] unsigned height) {}
+    void ExecInsertIntoLeaf([[maybe_unused]] Page<K>* leaf,
+                            [[maybe_unused]] uint64_t old_node_ver,
+                            [[maybe_unused]] Page<K>* split_lpage,
+                            [[maybe_unused]] Page<K>* split_rpage) {}
+    void ExecEnterPut() {}
+    void ExecLeavePut() {}
+    void ExecLeaveGet() {}
+    void ExecEnterDelete() {}
+    void ExecLeaveDelete() {}
+    void ExecLeaveScan() {}
+
+    /**
+     * Do a cheap staleness check of earlier reads upon each operation.
+     */
+    void ExecEnterGet() { RecheckOneRead(); }
+    void ExecEnterScan() { RecheckOneRead(); }
+
+    bool IsDoomed() const { return must_abort; }
+    TxnMode Mode() const { return TXN_READ_ONLY; }
+
+    /**
+     * Snapshot-consistency check; no locking.
+     */
+    bool TryCommit(std::atomic<uint64_t>* ser_counter = nullptr,
+                   uint64_t* ser_order = nullptr, TxnStats* stats = nullptr);
+
+    template <typename KK, typename VV>
+    friend std::ostream& operator<<(std::ostream& s,
+                                    const TxnReadOnly<KK, VV>& txn);
+};
+
+template <typename K, typename V>
+std::ostream& operator<<(std::ostream& s, const TxnReadOnly<K, V>& txn) {
+    s << "TxnReadOnly{read_vec=[";
+    for (auto&& [r, ver] : txn.read_vec) s << "(" << r << "-" << ver << "),";
+    s << "],node_set=" << txn.node_set << ",must_abort=" << txn.must_abort
+      << ",no_read_validation=" << txn.no_read_validation << "}";
+    return s;
+}
+
+}  // namespace garner
+
+// Include template implementation in-place.
+#include "txn_readonly.tpl.hpp"
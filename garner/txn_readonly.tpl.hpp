@@ -0,0 +1,111 @@
+// Template implementation included in-place by the ".hpp".
+
+#pragma once
+
+namespace garner {
+
+template <typename K, typename V>
+void TxnReadOnly<K, V>::Reset() {
+    read_vec.clear();
+    read_set.Clear();
+    node_set.Clear();
+    must_abort = false;
+    recheck_idx = 0;
+}
+
+template <typename K, typename V>
+void TxnReadOnly<K, V>::RecheckOneRead() {
+    if (must_abort || read_vec.empty()) return;
+
+    if (recheck_idx >= read_vec.size()) recheck_idx = 0;
+    auto&& ritem = read_vec[recheck_idx++];
+
+    uint64_t curr_tid = ritem.record->LoadTid();
+    if (Record<K, V>::TidVersion(curr_tid) != ritem.version) must_abort = true;
+}
+
+template <typename K, typename V>
+bool TxnReadOnly<K, V>::ExecReadRecord(Record<K, V>* record, V& value) {
+    V read_value;
+    uint64_t read_tid = record->ReadConsistent(read_value);
+    bool valid = Record<K, V>::TidValid(read_tid);
+    uint64_t read_version = Record<K, V>::TidVersion(read_tid);
+    if (valid) value = std::move(read_value);
+
+    // a phantom record without filled value reads as absent, but is tracked
+    // all the same, so that it getting filled before my commit is noticed
+
+    const size_t* read_idx = read_set.Find(record);
+    if (read_idx != nullptr) {
+        assert(*read_idx < read_vec.size());
+        if (read_vec[*read_idx].version != read_version) must_abort = true;
+    } else {
+        read_vec.push_back(
+            RecordListItem{.record = record, .version = read_version});
+        read_set.Insert(record, read_vec.size() - 1);
+    }
+
+    return valid;
+}
+
+template <typename K, typename V>
+void TxnReadOnly<K, V>::ExecWriteRecord([[maybe_unused]] Record<K, V>* record,
+                                        [[maybe_unused]] V value) {
+    throw GarnerException("write attempted in read-only transaction");
+}
+
+template <typename K, typename V>
+void TxnReadOnly<K, V>::ExecObserveLeaf(Page<K>* leaf) {
+    // leaf got a new key or split since I first observed it
+    if (!node_set.Observe(leaf)) must_abort = true;
+}
+
+template <typename K, typename V>
+bool TxnReadOnly<K, V>::TryCommit(std::atomic<uint64_t>* ser_counter,
+                                  uint64_t* ser_order, TxnStats* stats) {
+    if (must_abort) return false;
+
+    std::chrono::time_point<std::chrono::high_resolution_clock> start_tp;
+    if constexpr (build_options.txn_stat)
+        start_tp = std::chrono::high_resolution_clock::now();
+
+    // <-- serialization point -->
+    // versions only move forward, so a version found unchanged below was
+    // also the committed one at this point
+    if (ser_counter != nullptr && ser_order != nullptr)
+        *ser_order = (*ser_counter)++;
+
+    if (!no_read_validation) {
+        for (auto&& ritem : read_vec) {
+            // a writer holding the lock may have passed its serialization
+            // point already, so wait for its outcome instead of ignoring the
+            // lock; it is in its commit phase and releases the lock shortly
+            uint64_t curr_tid = ritem.record->LoadTid();
+            while (Record<K, V>::TidLocked(curr_tid)) {
+                std::this_thread::yield();
+                curr_tid = ritem.record->LoadTid();
+            }
+            if (Record<K, V>::TidVersion(curr_tid) != ritem.version)
+                return false;
+        }
+
+        // if any observed leaf got new keys or split, abort due to phantoms
+        if (!node_set.Validate()) return false;
+    }
+
+    // the whole commit is validation; no lock or write phases
+    if constexpr (build_options.txn_stat) {
+        if (stats != nullptr) {
+            stats->lock_time = 0;
+            stats->validate_time =
+                std::chrono::duration_cast<std::chrono::microseconds>(
+                    std::chrono::high_resolution_clock::now() - start_tp)
+                    .count();
+            stats->commit_time = 0;
+        }
+    }
+
+    return true;
+}
+
+}  // namespace garner
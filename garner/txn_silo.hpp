@@ -3,12 +3,16 @@
 #include <algorithm>
 #include <atomic>
 #include <iostream>
-#include <map>
 #include <vector>
 
 #include "build_options.hpp"
 #include "common.hpp"
+#include "epoch.hpp"
+#include "hot_locks.hpp"
+#include "node_set.hpp"
+#include "read_validation.hpp"
 #include "record.hpp"
+#include "small_map.hpp"
 #include "txn.hpp"
 
 #pragma once
@@ -18,6 +22,28 @@ namespace garner {
 /**
  * Silo transaction context type.
  * https://dl.acm.org/doi/10.1145/2517349.2522713
+ *
+ * If hot locking is on, records that recently failed validation often are
+ * locked at access time instead, see HotLocks.
+ *
+ * A stale read made only by Updates is repaired at commit time rather than
+ * aborting the transaction: since the record is in the write set, it is
+ * locked by then, so its current value is re-read and the Update functions
+ * re-run on it to recompute the write, in the spirit of transaction repair
+ * and transaction healing.
+ *
+ * Merges go one step further and skip the read altogether: their functions
+ * are only applied in the install phase, so concurrent Merges to a record
+ * serialize on its lock instead of failing validation.
+ *
+ * Under a weaker isolation level than ISOLATION_SERIALIZABLE, no read or
+ * node set is kept. ISOLATION_SNAPSHOT reads records from a snapshot as
+ * TxnSnapshot does, and at commit checks under the locks that every record
+ * written is still at the version the write builds on, so that the first
+ * committer wins: the version read from the snapshot, or for a blind write
+ * the latest version when first written. ISOLATION_READ_COMMITTED
+ * reads the latest committed values and turns Updates into Merges, leaving
+ * nothing to check at commit.
  */
 template <typename K, typename V>
 class TxnSilo : public TxnCxt<K, V> {
@@ -25,30 +51,146 @@ class TxnSilo : public TxnCxt<K, V> {
     // read list storing record -> read version
     // using an std::vector of items to speed up the sequential loop of
     // generating new version number
+    // an item is repairable if only read through Updates, i.e., its value
+    // never escaped to the client
     struct RecordListItem {
         Record<K, V>* record;
         uint64_t version;
+        bool repairable = false;
     };
 
     std::vector<RecordListItem> read_vec;
 
     // read set storing record -> index in read_vec
-    std::unordered_map<Record<K, V>*, size_t> read_set;
+    SmallMap<Record<K, V>*, size_t, 16> read_set;
 
-    // write set storing record -> new value
-    std::map<Record<K, V>*, V> write_set;
+    // write list storing record -> new value, sorted by record address at
+    // commit time for deadlock-free locking; value is computed by update from
+    // the record's read value if written by Updates only, or from its value
+    // at commit time if merge is set, i.e., written by Merges only and never
+    // read; base_version is the version the write builds on under
+    // ISOLATION_SNAPSHOT
+    struct WriteListItem {
+        Record<K, V>* record;
+        V value;
+        typename TxnCxt<K, V>::UpdateFn update = nullptr;
+        bool merge = false;
+        uint64_t base_version = 0;
+    };
+
+    std::vector<WriteListItem> write_vec;
+
+    // write set storing record -> index in write_vec
+    SmallMap<Record<K, V>*, size_t, 16> write_set;
+
+    // under ISOLATION_SNAPSHOT, record -> version read from the snapshot, in
+    // place of the read set
+    SmallMap<Record<K, V>*, uint64_t, 16> snap_read_set;
+
+    // leaf node versions observed by negative lookups and scans, for
+    // detecting phantoms
+    NodeSet<K> node_set;
 
     // true if abort decision already made during execution
     bool must_abort = false;
 
+    // index into read_vec of the next earlier read to re-check
+    size_t recheck_idx = 0;
+
+    // locks taken on hot records, if hot locking is on
+    const bool hot_locking = false;
+    HotLocks<K, V> hot_locks;
+
+    // true while inside a Scan, i.e., holding a leaf page latch on reads
+    bool in_scan = false;
+
+    // isolation level, and under ISOLATION_SNAPSHOT the snapshot epoch
+    // picked upon the first operation, 0 if not picked yet
+    const TxnIsolation isolation = ISOLATION_SERIALIZABLE;
+    uint64_t snap_epoch = 0;
+
+    /**
+     * Under ISOLATION_SNAPSHOT, pick the snapshot epoch if not picked yet.
+     */
+    void PickSnapshot() {
+        if (isolation == ISOLATION_SNAPSHOT && snap_epoch == 0)
+            snap_epoch = EpochManager::Global().SnapshotEpoch();
+    }
+
+    /**
+     * Read record under a weaker isolation level, without tracking it.
+     */
+    bool ReadUntracked(Record<K, V>* record, V& value);
+
+    /**
+     * Under ISOLATION_SNAPSHOT, the version a new write to record builds on:
+     * the version read from the snapshot if read before, else the latest
+     * one. 0 under other isolation levels.
+     */
+    uint64_t BaseVersion(Record<K, V>* record) const;
+
+    /**
+     * Under ISOLATION_SNAPSHOT, check that every record to be overwritten is
+     * still at the version its write builds on. Must hold all write locks.
+     */
+    bool WritesInSnapshot() const;
+
+    /**
+     * Repair a stale read of record at commit time, re-running its Update
+     * functions on the current value. Must hold record's lock, and write_vec
+     * must be sorted. Returns false if the read cannot be repaired.
+     */
+    bool RepairRead(Record<K, V>* record);
+
+    /**
+     * Validate all reads in read_vec, batch by batch. Must hold all write
+     * locks. Returns false if any read is stale and cannot be repaired.
+     */
+    bool ValidateReads();
+
+    /**
+     * Apply fn on top of my own write to record, if any, chaining it onto
+     * the write's pending functions. Returns false if record is not in my
+     * write set.
+     */
+    bool UpdateOwnWrite(Record<K, V>* record,
+                        const typename TxnCxt<K, V>::UpdateFn& fn);
+
+    /**
+     * Re-check the version of one earlier read per operation in round-robin
+     * order, so that a transaction doomed by a concurrent writer gets caught
+     * during execution at O(1) cost per operation.
+     */
+    void RecheckOneRead();
+
    public:
-    TxnSilo() : TxnCxt<K, V>(), read_set(), write_set(), must_abort(false) {}
+    TxnSilo(bool hot_locking = false,
+            TxnIsolation isolation = ISOLATION_SERIALIZABLE)
+        : TxnCxt<K, V>(),
+          read_vec(),
+          read_set(),
+          write_vec(),
+          write_set(),
+          snap_read_set(),
+          node_set(),
+          must_abort(false),
+          recheck_idx(0),
+          hot_locking(hot_locking),
+          hot_locks(),
+          in_scan(false),
+          isolation(isolation),
+          snap_epoch(0) {}
 
     TxnSilo(const TxnSilo&) = delete;
     TxnSilo& operator=(const TxnSilo&) = delete;
 
     ~TxnSilo() = default;
 
+    /**
+     * Clear read/write sets for recycling, keeping their capacity.
+     */
+    void Reset();
+
     /**
      * Save record to read set, set value to its current read value.
      * Returns true if read is successful, or false if reading a phantom
@@ -61,20 +203,66 @@ class TxnSilo : public TxnCxt<K, V> {
      */
     void ExecWriteRecord(Record<K, V>* record, V value);
 
+    /**
+     * Read record into read set as repairable, then save fn's result to
+     * write set, remembering fn for repair. Under weaker isolation levels,
+     * handled as a Merge or as a plain read and write instead.
+     */
+    void ExecUpdateRecord(Record<K, V>* record,
+                          const typename TxnCxt<K, V>::UpdateFn& fn);
+
+    /**
+     * Save fn to write set without reading record, to be applied at commit
+     * time while holding its lock.
+     */
+    void ExecMergeRecord(Record<K, V>* record,
+                         const typename TxnCxt<K, V>::UpdateFn& fn);
+
+    /**
+     * Save leaf to node set with its current node version, if serializable.
+     */
+    void ExecObserveLeaf(Page<K>* leaf);
+
+    /**
+     * Follow node version bumps caused by my own insertion into leaf, which
+     * may have split it, in which case the new leaf pages are given.
+     */
+    void ExecInsertIntoLeaf(Page<K>* leaf, uint64_t old_node_ver,
+                            Page<K>* split_lpage, Page<K>* split_rpage);
+
     /**
      * Not used.
      */
     void ExecReadTraverseNode([[maybe_unused]] Page<K>* page) {}
     void ExecWriteTraverseNode([[maybe_unused]] Page<K>* page,
                                [[maybe_unused]] unsigned height) {}
-    void ExecEnterPut() {}
     void ExecLeavePut() {}
-    void ExecEnterGet() {}
     void ExecLeaveGet() {}
-    void ExecEnterDelete() {}
     void ExecLeaveDelete() {}
-    void ExecEnterScan() {}
-    void ExecLeaveScan() {}
+
+    /**
+     * Pick the snapshot if needed, and do a cheap staleness check of earlier
+     * reads upon each operation.
+     */
+    void ExecEnterPut() {
+        PickSnapshot();
+        RecheckOneRead();
+    }
+    void ExecEnterGet() {
+        PickSnapshot();
+        RecheckOneRead();
+    }
+    void ExecEnterDelete() { PickSnapshot(); }
+    void ExecEnterScan() {
+        in_scan = true;
+        PickSnapshot();
+        RecheckOneRead();
+    }
+    void ExecLeaveScan() { in_scan = false; }
+
+    bool IsDoomed() const { return must_abort; }
+    TxnMode Mode() const { return TXN_READ_WRITE; }
+    TxnIsolation Isolation() const { return isolation; }
 
     /**
      * Silo validation and commit protocol.
@@ -102,9 +290,11 @@ std::ostream& operator<<(std::ostream& s,
 template <typename K, typename V>
 std::ostream& operator<<(std::ostream& s, const TxnSilo<K, V>& txn) {
     s << "TxnSilo{read_vec=[";
-    for (auto&& [r, ver] : txn.read_vec) s << "(" << r << "-" << ver << "),";
+    for (auto&& ritem : txn.read_vec)
+        s << "(" << ritem.record << "-" << ritem.version << "),";
     s << "],write_set=[";
-    for (auto&& [r, val] : txn.write_set) s << "(" << r << "-" << val << "),";
+    for (auto&& witem : txn.write_vec)
+        s << "(" << witem.record << "-" << witem.value << "),";
     s << "],must_abort=" << txn.must_abort << "}";
     return s;
 }
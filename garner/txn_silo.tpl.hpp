@@ -4,55 +4,302 @@
 
 namespace garner {
 
+template <typename K, typename V>
+void TxnSilo<K, V>::Reset() {
+    read_vec.clear();
+    read_set.Clear();
+    write_vec.clear();
+    write_set.Clear();
+    snap_read_set.Clear();
+    node_set.Clear();
+    must_abort = false;
+    recheck_idx = 0;
+    hot_locks.ReleaseAll();
+    in_scan = false;
+    snap_epoch = 0;
+}
+
+template <typename K, typename V>
+void TxnSilo<K, V>::RecheckOneRead() {
+    if (must_abort || read_vec.empty()) return;
+
+    if (recheck_idx >= read_vec.size()) recheck_idx = 0;
+    auto&& ritem = read_vec[recheck_idx++];
+    if (ritem.repairable) return;
+
+    // a record locked by another writer may still be released unchanged,
+    // so only a committed version change dooms us
+    uint64_t curr_tid = ritem.record->LoadTid();
+    if (Record<K, V>::TidVersion(curr_tid) != ritem.version) {
+        ritem.record->BumpTemperature();
+        must_abort = true;
+    }
+}
+
+template <typename K, typename V>
+bool TxnSilo<K, V>::ReadUntracked(Record<K, V>* record, V& value) {
+    V read_value;
+    uint64_t read_tid;
+    if (isolation == ISOLATION_SNAPSHOT) {
+        assert(snap_epoch > 0);
+        bool too_old;
+        read_tid = record->ReadSnapshot(snap_epoch, read_value, too_old);
+        if (too_old) must_abort = true;
+    } else
+        read_tid = record->ReadConsistent(read_value);
+    bool valid = Record<K, V>::TidValid(read_tid);
+
+    const size_t* write_idx = write_set.Find(record);
+    if (write_idx == nullptr) {
+        // remember the version seen, which a later write to record builds on
+        if (isolation == ISOLATION_SNAPSHOT && !snap_read_set.Contains(record))
+            snap_read_set.Insert(record, Record<K, V>::TidVersion(read_tid));
+        if (valid) value = std::move(read_value);
+        return valid;
+    }
+
+    // my own write shows through; a pending Merge gets applied on the value
+    // just read, as in ExecReadRecord, so the write now builds on it
+    assert(*write_idx < write_vec.size());
+    auto&& witem = write_vec[*write_idx];
+    if (witem.merge) {
+        witem.value = witem.update(read_value, valid);
+        witem.merge = false;
+        witem.base_version = Record<K, V>::TidVersion(read_tid);
+    }
+    value = witem.value;
+    return true;
+}
+
 template <typename K, typename V>
 bool TxnSilo<K, V>::ExecReadRecord(Record<K, V>* record, V& value) {
-    // fetch value and version
-    record->latch.lock_shared();
-    DEBUG("record latch R acquire %p", static_cast<void*>(record));
-    bool valid = record->valid;
-    V read_value = record->value;
-    uint64_t read_version = record->version;
-    record->latch.unlock_shared();
-    DEBUG("record latch R release %p", static_cast<void*>(record));
-
-    // if is a phantom record without filled value, ignore
-    if (!write_set.contains(record) && !valid) return false;
-
-    // if in my local write set, read from there instead
-    if (write_set.contains(record))
-        value = write_set[record];
-    else
+    // nothing to track, and no read to protect with hot locks
+    if (isolation != ISOLATION_SERIALIZABLE)
+        return ReadUntracked(record, value);
+
+    if (hot_locking && !must_abort) hot_locks.LockIfHot(record, !in_scan);
+
+    // fetch value and version, seqlock-style without writing to record
+    V read_value;
+    uint64_t read_tid = record->ReadConsistent(read_value);
+    bool valid = Record<K, V>::TidValid(read_tid);
+    uint64_t read_version = Record<K, V>::TidVersion(read_tid);
+
+    // if in my local write set, read from there instead; a pending Merge
+    // gets applied on the value just read, which is then tracked as usual
+    const size_t* write_idx = write_set.Find(record);
+    if (write_idx != nullptr) {
+        assert(*write_idx < write_vec.size());
+        auto&& witem = write_vec[*write_idx];
+        if (witem.merge) {
+            witem.value = witem.update(read_value, valid);
+            witem.merge = false;
+        }
+        value = witem.value;
+    } else if (valid)
         value = std::move(read_value);
 
-    // insert into read set if not in it yet
-    if (read_set.contains(record)) {
-        assert(read_set[record] < read_vec.size());
-        if (read_vec[read_set[record]].version != read_version) {
+    // insert into read set if not in it yet; the value now escapes to the
+    // client, so it can no longer be repaired; a phantom record without
+    // filled value reads as absent, but is tracked all the same, so that
+    // another transaction filling it before my commit fails validation
+    const size_t* read_idx = read_set.Find(record);
+    if (read_idx != nullptr) {
+        assert(*read_idx < read_vec.size());
+        read_vec[*read_idx].repairable = false;
+        if (read_vec[*read_idx].version != read_version) {
             // same record read multiple times by the transaction and versions
-            // already mismatch
-            // we could just early abort here, but for simplicity, we save
-            // this decision and abort at finish time
+            // already mismatch; doom the transaction so that subsequent
+            // operations return early, and abort at finish time
+            record->BumpTemperature();
             must_abort = true;
         }
     } else {
         read_vec.push_back(
             RecordListItem{.record = record, .version = read_version});
-        read_set[record] = read_vec.size() - 1;
+        read_set.Insert(record, read_vec.size() - 1);
     }
 
-    return true;
+    return write_idx != nullptr || valid;
 }
 
 template <typename K, typename V>
 void TxnSilo<K, V>::ExecWriteRecord(Record<K, V>* record, V value) {
-    // do not actually write; save value locally
-    write_set[record] = std::move(value);
+    if (hot_locking && !must_abort) hot_locks.LockIfHot(record, !in_scan);
+
+    // do not actually write; save value locally, which no longer depends on
+    // earlier Updates
+    size_t* write_idx = write_set.Find(record);
+    if (write_idx != nullptr) {
+        assert(*write_idx < write_vec.size());
+        write_vec[*write_idx].value = std::move(value);
+        write_vec[*write_idx].update = nullptr;
+        write_vec[*write_idx].merge = false;
+    } else {
+        write_vec.push_back(WriteListItem{.record = record,
+                                          .value = std::move(value),
+                                          .base_version = BaseVersion(record)});
+        write_set.Insert(record, write_vec.size() - 1);
+    }
+}
+
+template <typename K, typename V>
+bool TxnSilo<K, V>::UpdateOwnWrite(
+    Record<K, V>* record, const typename TxnCxt<K, V>::UpdateFn& fn) {
+    size_t* write_idx = write_set.Find(record);
+    if (write_idx == nullptr) return false;
+    assert(*write_idx < write_vec.size());
+
+    // if that write came from Updates or Merges, chain fn onto them so that
+    // a repair or the install re-runs all; a pending Merge has no value yet
+    auto&& witem = write_vec[*write_idx];
+    if (!witem.merge) witem.value = fn(witem.value, true);
+    if (witem.update) {
+        witem.update = [prev = std::move(witem.update), fn](const V& value,
+                                                            bool found) {
+            return fn(prev(value, found), true);
+        };
+    }
+    return true;
+}
+
+template <typename K, typename V>
+void TxnSilo<K, V>::ExecUpdateRecord(
+    Record<K, V>* record, const typename TxnCxt<K, V>::UpdateFn& fn) {
+    // read committed defers the whole Update to the install phase; snapshot
+    // isolation checks every write at commit anyway, so needs no repair
+    if (isolation == ISOLATION_READ_COMMITTED) {
+        ExecMergeRecord(record, fn);
+        return;
+    }
+    if (isolation == ISOLATION_SNAPSHOT) {
+        TxnCxt<K, V>::ExecUpdateRecord(record, fn);
+        return;
+    }
+
+    if (hot_locking && !must_abort) hot_locks.LockIfHot(record, !in_scan);
+
+    // building upon my own write needs no read
+    if (UpdateOwnWrite(record, fn)) return;
+
+    // unlike plain reads, a phantom record is read as well, since someone
+    // filling it in makes the not-found read stale
+    V read_value;
+    uint64_t read_tid = record->ReadConsistent(read_value);
+    bool valid = Record<K, V>::TidValid(read_tid);
+    uint64_t read_version = Record<K, V>::TidVersion(read_tid);
+
+    const size_t* read_idx = read_set.Find(record);
+    if (read_idx != nullptr) {
+        assert(*read_idx < read_vec.size());
+        if (read_vec[*read_idx].version != read_version) {
+            record->BumpTemperature();
+            must_abort = true;
+            return;
+        }
+    } else {
+        read_vec.push_back(RecordListItem{
+            .record = record, .version = read_version, .repairable = true});
+        read_set.Insert(record, read_vec.size() - 1);
+    }
+
+    write_vec.push_back(WriteListItem{.record = record,
+                                      .value = fn(read_value, valid),
+                                      .update = fn});
+    write_set.Insert(record, write_vec.size() - 1);
+}
+
+template <typename K, typename V>
+void TxnSilo<K, V>::ExecMergeRecord(
+    Record<K, V>* record, const typename TxnCxt<K, V>::UpdateFn& fn) {
+    // no hot locking, since a Merge never fails validation
+    if (UpdateOwnWrite(record, fn)) return;
+
+    write_vec.push_back(WriteListItem{.record = record,
+                                      .value = V(),
+                                      .update = fn,
+                                      .merge = true,
+                                      .base_version = BaseVersion(record)});
+    write_set.Insert(record, write_vec.size() - 1);
+}
+
+template <typename K, typename V>
+bool TxnSilo<K, V>::RepairRead(Record<K, V>* record) {
+    auto it = std::lower_bound(
+        write_vec.begin(), write_vec.end(), record,
+        [](const WriteListItem& witem, const Record<K, V>* r) {
+            return reinterpret_cast<uint64_t>(witem.record) <
+                   reinterpret_cast<uint64_t>(r);
+        });
+    assert(it != write_vec.end() && it->record == record);
+
+    // overwritten by a blind write since; the stale value has still been
+    // seen by the Update functions, which are gone, so cannot repair
+    if (!it->update) return false;
+
+    V value;
+    bool found = record->ReadLocked(value);
+    it->value = it->update(value, found);
+    DEBUG("record read repaired %p", static_cast<void*>(record));
+    return true;
+}
+
+template <typename K, typename V>
+uint64_t TxnSilo<K, V>::BaseVersion(Record<K, V>* record) const {
+    if (isolation != ISOLATION_SNAPSHOT) return 0;
+
+    // a blind write only conflicts with commits after it, not with those
+    // between the snapshot and now, which it never saw
+    const uint64_t* read_version = snap_read_set.Find(record);
+    if (read_version != nullptr) return *read_version;
+    return Record<K, V>::TidVersion(record->LoadTid());
+}
+
+template <typename K, typename V>
+bool TxnSilo<K, V>::WritesInSnapshot() const {
+    for (auto&& witem : write_vec) {
+        // a Merge does not depend on the value it overwrites
+        if (witem.merge) continue;
+
+        // I hold the lock, so this is the latest committed version
+        uint64_t curr_tid = witem.record->LoadTid();
+        if (Record<K, V>::TidVersion(curr_tid) != witem.base_version)
+            return false;
+    }
+    return true;
+}
+
+template <typename K, typename V>
+bool TxnSilo<K, V>::ValidateReads() {
+    return ValidateReadBatches(
+        read_vec.begin(), read_vec.end(),
+        [&](Record<K, V>* record) { return write_set.Contains(record); },
+        [&](Record<K, V>* record) { return RepairRead(record); });
+}
+
+template <typename K, typename V>
+void TxnSilo<K, V>::ExecObserveLeaf(Page<K>* leaf) {
+    // phantoms are only prevented at ISOLATION_SERIALIZABLE
+    if (isolation != ISOLATION_SERIALIZABLE) return;
+
+    // leaf got a new key or split since I first observed it
+    if (!node_set.Observe(leaf)) must_abort = true;
+}
+
+template <typename K, typename V>
+void TxnSilo<K, V>::ExecInsertIntoLeaf(Page<K>* leaf, uint64_t old_node_ver,
+                                       Page<K>* split_lpage,
+                                       Page<K>* split_rpage) {
+    node_set.Inserted(leaf, old_node_ver, split_lpage, split_rpage);
 }
 
 template <typename K, typename V>
 bool TxnSilo<K, V>::TryCommit(std::atomic<uint64_t>* ser_counter,
                               uint64_t* ser_order, TxnStats* stats) {
-    if (must_abort) return false;
+    if (must_abort) {
+        hot_locks.ReleaseAll();
+        return false;
+    }
 
     std::chrono::time_point<std::chrono::high_resolution_clock> start_tp;
     if constexpr (build_options.txn_stat)
@@ -60,84 +307,91 @@ bool TxnSilo<K, V>::TryCommit(std::atomic<uint64_t>* ser_counter,
 
     // phase 1: lock for writes
     // lock in memory address order to prevent deadlocks
-    // std::map is already sorted by key
-    for (auto&& [record, _] : write_set) {
-        record->latch.lock();
-        DEBUG("record latch W acquire %p", static_cast<void*>(record));
+    // after sorting, write_set only serves membership checks since its
+    // indices into write_vec are stale
+    std::sort(write_vec.begin(), write_vec.end(),
+              [](const WriteListItem& wa, const WriteListItem& wb) {
+                  return reinterpret_cast<uint64_t>(wa.record) <
+                         reinterpret_cast<uint64_t>(wb.record);
+              });
+
+    for (auto&& witem : write_vec) {
+        witem.record->Lock();
+        DEBUG("record latch W acquire %p", static_cast<void*>(witem.record));
     }
 
     auto release_all_write_latches = [&]() {
-        for (auto&& [record, _] : write_set) {
-            record->latch.unlock();
-            DEBUG("record latch W release %p", static_cast<void*>(record));
+        for (auto&& witem : write_vec) {
+            witem.record->Unlock();
+            DEBUG("record latch W release %p",
+                  static_cast<void*>(witem.record));
         }
+        hot_locks.ReleaseAll();
     };
 
+    // a record locked by a hot-record holder must not change under it
+    if (hot_locking) {
+        for (auto&& witem : write_vec) {
+            if (!hot_locks.MayInstall(witem.record)) {
+                witem.record->BumpTemperature();
+                release_all_write_latches();
+                return false;
+            }
+        }
+    }
+
     std::chrono::time_point<std::chrono::high_resolution_clock> end_lock_tp;
     if constexpr (build_options.txn_stat)
         end_lock_tp = std::chrono::high_resolution_clock::now();
 
+    // stay in an epoch critical section until all writes are installed, so
+    // that the global epoch cannot move two past my commit TID's epoch
+    // before then; snapshot reads rely on this
+    EpochGuard epoch_guard;
+
     // <-- serialization point -->
     if (ser_counter != nullptr && ser_order != nullptr)
         *ser_order = (*ser_counter)++;
 
-    // phase 2
-    for (auto&& ritem : read_vec) {
-        auto&& record = ritem.record;
-        auto&& version = ritem.version;
-
-        // if possibly locked by some writer other than me, abort
-        bool latched = false;
-        bool me_writing = write_set.contains(record);
-        if (!me_writing) {
-            latched = record->latch.try_lock_shared();
-            DEBUG("record latch R try_acquire %p %s",
-                  static_cast<void*>(record), latched ? "yes" : "no");
-            if (!latched) {
-                release_all_write_latches();
-                return false;
-            }
-        }
+    // generate commit TID from current epoch and worker-local sequence
+    uint64_t new_version = EpochManager::Global().NewCommitTid();
 
-        // if version mismatch, abort
-        if (!me_writing && !latched) {
-            record->latch.lock_shared();
-            DEBUG("record latch R acquire %p", static_cast<void*>(record));
-        }
-        uint64_t curr_version = record->version;
-        if (!me_writing) {
-            record->latch.unlock_shared();
-            DEBUG("record latch R release %p", static_cast<void*>(record));
-        }
+    // under snapshot isolation, the first committer to a record wins; the
+    // read and node sets are empty then, so phase 2 below is a no-op
+    if (isolation == ISOLATION_SNAPSHOT && !WritesInSnapshot()) {
+        release_all_write_latches();
+        return false;
+    }
 
-        if (version != curr_version) {
-            release_all_write_latches();
-            return false;
-        }
+    // phase 2
+    if (!ValidateReads()) {
+        release_all_write_latches();
+        return false;
+    }
+
+    // if any observed leaf got new keys or split, abort due to phantoms
+    if (!node_set.Validate()) {
+        release_all_write_latches();
+        return false;
     }
 
     std::chrono::time_point<std::chrono::high_resolution_clock> end_validate_tp;
     if constexpr (build_options.txn_stat)
         end_validate_tp = std::chrono::high_resolution_clock::now();
 
-    // generate new version number, one greater than all versions seen by
-    // this transaction
-    uint64_t new_version = 0;
-    for (auto&& ritem : read_vec)
-        if (ritem.version > new_version) new_version = ritem.version;
-    for (auto&& [record, _] : write_set)
-        if (record->version > new_version) new_version = record->version;
-    new_version++;
-
-    // phase 3: reflect writes with new version number
-    for (auto&& [record, value] : write_set) {
-        record->value = std::move(value);
-        record->version = new_version;
-        record->valid = true;
-
-        record->latch.unlock();
-        DEBUG("record latch W release %p", static_cast<void*>(record));
+    // phase 3: reflect writes with new version number, applying Merges on
+    // the latest values under the locks
+    for (auto&& witem : write_vec) {
+        if (witem.merge) {
+            V value;
+            bool found = witem.record->ReadLocked(value);
+            witem.value = witem.update(value, found);
+        }
+        witem.record->InstallValue(std::move(witem.value), new_version);
+        witem.record->UnlockWithVersion(new_version);
+        DEBUG("record latch W release %p", static_cast<void*>(witem.record));
     }
+    hot_locks.ReleaseAll();
 
     std::chrono::time_point<std::chrono::high_resolution_clock> end_commit_tp;
     if constexpr (build_options.txn_stat)
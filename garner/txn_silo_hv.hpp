@@ -2,17 +2,23 @@
 
 #include <algorithm>
 #include <atomic>
+#include <climits>
+#include <cstdint>
 #include <iostream>
 #include <tuple>
-#include <unordered_map>
 #include <utility>
 #include <variant>
 #include <vector>
 
 #include "build_options.hpp"
 #include "common.hpp"
+#include "epoch.hpp"
+#include "hot_locks.hpp"
+#include "node_set.hpp"
 #include "page.hpp"
+#include "read_validation.hpp"
 #include "record.hpp"
+#include "small_map.hpp"
 #include "txn.hpp"
 
 #pragma once
@@ -20,7 +26,9 @@
 namespace garner {
 
 /**
- * Silo transaction context type with hierarchical validation.
+ * Silo transaction context type with hierarchical validation. Hot locking,
+ * read repair, deferred Merges and weaker isolation levels work the same as
+ * in TxnSilo; under the latter, read traversals are not tracked either.
  */
 template <typename K, typename V>
 class TxnSiloHV : public TxnCxt<K, V> {
@@ -28,10 +36,12 @@ class TxnSiloHV : public TxnCxt<K, V> {
     // we split the read_list into two vectors: one for tree nodes (pages) and
     // the other for records, to give better memory performance
 
-    // record list storing record -> read version in traversal order
+    // record list storing record -> read version in traversal order; an
+    // item is repairable if only read through Updates
     struct RecordListItem {
         Record<K, V>* record;
         uint64_t version;
+        bool repairable = false;
     };
 
     std::vector<RecordListItem> record_list;
@@ -50,16 +60,27 @@ class TxnSiloHV : public TxnCxt<K, V> {
 
     // still maintain a map from node/record -> index in record_list/page_list,
     // for fast lookups
-    std::unordered_map<Record<K, V>*, size_t> record_set;
-    std::unordered_map<Page<K>*, size_t> page_set;
+    SmallMap<Record<K, V>*, size_t, 16> record_set;
+    SmallMap<Page<K>*, size_t, 16> page_set;
 
-    // auxiliary map from height -> index of last enqueued node item, used for
-    // setting skip_to information during Scan execution
-    std::unordered_map<unsigned, size_t> last_read_node;
-    bool in_scan = false;
+    // auxiliary array from height -> index of the open node item at that
+    // height, NO_NODE if none; a node item stays open while every read
+    // traversal passes through it, so everything read since it was pushed
+    // lies in its subtree and is covered by its skip range
+    static constexpr size_t NO_NODE = SIZE_MAX;
+    std::vector<size_t> last_read_node;
+
+    /**
+     * Close open node items at given height and below, setting their skip
+     * ranges to end at current positions of the read lists.
+     */
+    void CloseReadNodes(unsigned height);
 
     // write list storing node/record -> new value in traversal order
-    // first field true means a B+-tree node, else a record
+    // first field true means a B+-tree node, else a record; a record's value
+    // is computed by update from its read value if written by Updates only,
+    // or from its value at commit time if merge is set; base_version is the
+    // version a record write builds on under ISOLATION_SNAPSHOT
     struct WriteListItem {
         bool is_record;
         union {
@@ -67,39 +88,196 @@ class TxnSiloHV : public TxnCxt<K, V> {
             Record<K, V>* record;
         };
         std::variant<unsigned, V> height_or_value;
+        typename TxnCxt<K, V>::UpdateFn update = nullptr;
+        bool merge = false;
+        uint64_t base_version = 0;
     };
 
     std::vector<WriteListItem> write_list;
 
     // still maintain a map from node/record -> index in write_list, for fast
     // lookups
-    std::unordered_map<void*, size_t> write_set;
+    SmallMap<void*, size_t, 16> write_set;
+
+    // under ISOLATION_SNAPSHOT, record -> version read from the snapshot, in
+    // place of the record list
+    SmallMap<Record<K, V>*, uint64_t, 16> snap_read_set;
+
+    // leaf node versions observed by negative lookups and scans, for
+    // detecting phantoms
+    NodeSet<K> node_set;
 
     // true if abort decision already made during execution
     bool must_abort = false;
 
+    // index into record_list of the next earlier read to re-check
+    size_t recheck_idx = 0;
+
+    /**
+     * Re-check the version of one earlier read per operation in round-robin
+     * order, so that a transaction doomed by a concurrent writer gets caught
+     * during execution at O(1) cost per operation.
+     */
+    void RecheckOneRead();
+
     // set true to completely turn off read validation as performance roofline
     const bool no_read_validation = false;
 
+    // pages higher than this are not tracked for hierarchical validation, 0
+    // means tracking all the way from root; pages close to root cover too
+    // many records to ever be found unchanged under concurrent writes, so
+    // tracking them is mostly wasted effort
+    const unsigned hv_max_height = 0;
+
+    /**
+     * Returns true if pages at given height take part in hierarchical
+     * validation.
+     */
+    bool HVTracked(unsigned height) const {
+        return hv_max_height == 0 || height <= hv_max_height;
+    }
+
+    // adaptive mode: a transaction starts with plain record validation and
+    // begins tracking read pages only once it scans or its read set grows
+    // past ADAPTIVE_READ_THRESHOLD, and only if hierarchical validation has
+    // been skipping enough records on this context lately; writers always
+    // maintain page versions, since concurrent readers may be tracking
+    const bool adaptive = false;
+
+    static constexpr size_t ADAPTIVE_READ_THRESHOLD = 16;
+    static constexpr double ADAPTIVE_MIN_SKIP_RATIO = 0.2;
+    static constexpr double ADAPTIVE_EWMA_WEIGHT = 0.1;
+    static constexpr unsigned ADAPTIVE_PROBE_PERIOD = 32;
+
+    // true if read traversals are tracked in page_list in this transaction
+    bool track_reads = true;
+
+    // true if adaptive decision already made in this transaction
+    bool adapt_decided = false;
+
+    // moving average of the fraction of records read after tracking started
+    // that validation could skip, and number of decisions made against
+    // tracking since last probe; kept across Reset() so that they sum up
+    // the recent transactions run on this context
+    double hv_skip_ratio = 1.0;
+    unsigned nskipped_tracking = 0;
+
+    /**
+     * In adaptive mode, decide whether to start tracking read pages upon
+     * entering an operation.
+     */
+    void AdaptTracking(bool entering_scan);
+
+    /**
+     * In adaptive mode, fold the outcome of a completed hierarchical
+     * validation into the moving average.
+     */
+    void AdaptRecordSkips(size_t nchecked);
+
+    // locks taken on hot records, if hot locking is on
+    const bool hot_locking = false;
+    HotLocks<K, V> hot_locks;
+
+    // true while inside a Scan, i.e., holding a leaf page latch on reads
+    bool in_scan = false;
+
+    // isolation level, and under ISOLATION_SNAPSHOT the snapshot epoch
+    // picked upon the first operation, 0 if not picked yet
+    const TxnIsolation isolation = ISOLATION_SERIALIZABLE;
+    uint64_t snap_epoch = 0;
+
+    /**
+     * Under ISOLATION_SNAPSHOT, pick the snapshot epoch if not picked yet.
+     */
+    void PickSnapshot() {
+        if (isolation == ISOLATION_SNAPSHOT && snap_epoch == 0)
+            snap_epoch = EpochManager::Global().SnapshotEpoch();
+    }
+
+    /**
+     * Read record under a weaker isolation level, without tracking it.
+     */
+    bool ReadUntracked(Record<K, V>* record, V& value);
+
+    /**
+     * Under ISOLATION_SNAPSHOT, the version a new write to record builds on:
+     * the version read from the snapshot if read before, else the latest
+     * one. 0 under other isolation levels.
+     */
+    uint64_t BaseVersion(Record<K, V>* record) const;
+
+    /**
+     * Under ISOLATION_SNAPSHOT, check that every record to be overwritten is
+     * still at the version its write builds on. Must hold all write locks.
+     */
+    bool WritesInSnapshot() const;
+
+    /**
+     * Repair a stale read of record at commit time, re-running its Update
+     * functions on the current value. Must hold record's lock, and
+     * write_list must be sorted. Returns false if the read cannot be
+     * repaired.
+     */
+    bool RepairRead(Record<K, V>* record);
+
+    // how many pages ahead to prefetch during validation
+    static constexpr size_t PAGE_PREFETCH_DIST = 8;
+
+    /**
+     * Validate records in record_list within [begin, end), batch by batch,
+     * prefetching the TID words of the next batch while checking the
+     * current one. Must hold all write locks. Returns false if any read is
+     * stale and cannot be repaired.
+     */
+    bool ValidateRecords(size_t begin, size_t end);
+
+    /**
+     * Apply fn on top of my own write to record, if any, chaining it onto
+     * the write's pending functions. Returns false if record is not in my
+     * write set.
+     */
+    bool UpdateOwnWrite(Record<K, V>* record,
+                        const typename TxnCxt<K, V>::UpdateFn& fn);
+
    public:
-    TxnSiloHV(bool no_read_validation = false)
+    TxnSiloHV(bool no_read_validation = false, unsigned hv_max_height = 0,
+              bool adaptive = false, bool hot_locking = false,
+              TxnIsolation isolation = ISOLATION_SERIALIZABLE)
         : TxnCxt<K, V>(),
           record_list(),
           page_list(),
           record_set(),
           page_set(),
           last_read_node(),
-          in_scan(false),
           write_list(),
           write_set(),
+          snap_read_set(),
+          node_set(),
           must_abort(false),
-          no_read_validation(no_read_validation) {}
+          recheck_idx(0),
+          no_read_validation(no_read_validation),
+          hv_max_height(hv_max_height),
+          adaptive(adaptive),
+          track_reads(!adaptive),
+          adapt_decided(false),
+          hv_skip_ratio(1.0),
+          nskipped_tracking(0),
+          hot_locking(hot_locking),
+          hot_locks(),
+          in_scan(false),
+          isolation(isolation),
+          snap_epoch(0) {}
 
     TxnSiloHV(const TxnSiloHV&) = delete;
     TxnSiloHV& operator=(const TxnSiloHV&) = delete;
 
     ~TxnSiloHV() = default;
 
+    /**
+     * Clear read/write lists and sets for recycling, keeping their capacity.
+     */
+    void Reset();
+
     /**
      * Save record to read set, set value to its current read value.
      * Returns true if read is successful, or false if reading a phantom
@@ -112,6 +290,21 @@ class TxnSiloHV : public TxnCxt<K, V> {
      */
     void ExecWriteRecord(Record<K, V>* record, V value);
 
+    /**
+     * Read record into read set as repairable, then save fn's result to
+     * write set, remembering fn for repair. Under weaker isolation levels,
+     * handled as a Merge or as a plain read and write instead.
+     */
+    void ExecUpdateRecord(Record<K, V>* record,
+                          const typename TxnCxt<K, V>::UpdateFn& fn);
+
+    /**
+     * Save fn to write set without reading record, to be applied at commit
+     * time while holding its lock.
+     */
+    void ExecMergeRecord(Record<K, V>* record,
+                         const typename TxnCxt<K, V>::UpdateFn& fn);
+
     /**
      * Save traversal information on page node for read.
      */
@@ -122,21 +315,55 @@ class TxnSiloHV : public TxnCxt<K, V> {
      */
     void ExecWriteTraverseNode(Page<K>* page, unsigned height);
 
+    /**
+     * Save leaf to node set with its current node version, if serializable.
+     */
+    void ExecObserveLeaf(Page<K>* leaf);
+
+    /**
+     * Follow node version bumps caused by my own insertion into leaf, which
+     * may have split it, in which case the new leaf pages are given.
+     */
+    void ExecInsertIntoLeaf(Page<K>* leaf, uint64_t old_node_ver,
+                            Page<K>* split_lpage, Page<K>* split_rpage);
+
     /**
      * Not used.
      */
-    void ExecEnterPut() {}
     void ExecLeavePut() {}
-    void ExecEnterGet() {}
     void ExecLeaveGet() {}
-    void ExecEnterDelete() {}
     void ExecLeaveDelete() {}
 
     /**
-     * Turn on/off subtree crossing logic when entering/leaving a Scan.
+     * Pick the snapshot if needed, and do a cheap staleness check of earlier
+     * reads upon each operation.
      */
-    void ExecEnterScan();
-    void ExecLeaveScan();
+    void ExecEnterPut() {
+        PickSnapshot();
+        RecheckOneRead();
+    }
+    void ExecEnterGet() {
+        PickSnapshot();
+        AdaptTracking(false);
+        RecheckOneRead();
+    }
+    void ExecEnterDelete() { PickSnapshot(); }
+
+    bool IsDoomed() const { return must_abort; }
+    TxnMode Mode() const { return TXN_READ_WRITE; }
+    TxnIsolation Isolation() const { return isolation; }
+
+    /**
+     * Pick the snapshot if needed, and do a cheap staleness check of earlier
+     * reads upon entering a Scan.
+     */
+    void ExecEnterScan() {
+        in_scan = true;
+        PickSnapshot();
+        AdaptTracking(true);
+        RecheckOneRead();
+    }
+    void ExecLeaveScan() { in_scan = false; }
 
     /**
      * Silo hierarchical validation and commit protocol.
@@ -203,7 +430,10 @@ std::ostream& operator<<(std::ostream& s, const TxnSiloHV<K, V>& txn) {
     s << "],write_list=[";
     for (auto&& witem : txn.write_list) s << witem << ",";
     s << "],must_abort=" << txn.must_abort
-      << ",no_read_validation=" << txn.no_read_validation << "}";
+      << ",no_read_validation=" << txn.no_read_validation
+      << ",hv_max_height=" << txn.hv_max_height
+      << ",adaptive=" << txn.adaptive << ",track_reads=" << txn.track_reads
+      << "}";
     return s;
 }
 
@@ -5,125 +5,424 @@
 namespace garner {
 
 template <typename K, typename V>
-bool TxnSiloHV<K, V>::ExecReadRecord(Record<K, V>* record, V& value) {
-    // fetch value and version
-    record->latch.lock_shared();
-    DEBUG("record latch R acquire %p", static_cast<void*>(record));
-    bool valid = record->valid;
-    V read_value = record->value;
-    uint64_t read_version = record->version;
-    record->latch.unlock_shared();
-    DEBUG("record latch R release %p", static_cast<void*>(record));
-
-    // if is a phantom record without filled value, ignore
-    if (!write_set.contains(record) && !valid) return false;
-
-    // if in my local write set, read from there instead
-    if (write_set.contains(record)) {
-        assert(write_set[record] < write_list.size());
-        assert(write_list[write_set[record]].is_record);
-        value = std::get<V>(write_list[write_set[record]].height_or_value);
+void TxnSiloHV<K, V>::Reset() {
+    record_list.clear();
+    page_list.clear();
+    record_set.Clear();
+    page_set.Clear();
+    last_read_node.clear();
+    write_list.clear();
+    write_set.Clear();
+    snap_read_set.Clear();
+    node_set.Clear();
+    must_abort = false;
+    recheck_idx = 0;
+    track_reads = !adaptive;
+    adapt_decided = false;
+    hot_locks.ReleaseAll();
+    in_scan = false;
+    snap_epoch = 0;
+}
+
+template <typename K, typename V>
+void TxnSiloHV<K, V>::AdaptTracking(bool entering_scan) {
+    if (!adaptive || adapt_decided) return;
+    if (!entering_scan && record_list.size() < ADAPTIVE_READ_THRESHOLD)
+        return;
+    adapt_decided = true;
+
+    // track anyway every once in a while, so that the estimate can recover
+    // once pages become quiet again
+    if (hv_skip_ratio >= ADAPTIVE_MIN_SKIP_RATIO ||
+        ++nskipped_tracking >= ADAPTIVE_PROBE_PERIOD) {
+        track_reads = true;
+        nskipped_tracking = 0;
+    }
+}
+
+template <typename K, typename V>
+void TxnSiloHV<K, V>::AdaptRecordSkips(size_t nchecked) {
+    if (!adaptive || page_list.empty()) return;
+
+    // records read before the first tracked page are always checked
+    size_t first_tracked = page_list[0].record_idx_start;
+    size_t ntracked = record_list.size() - first_tracked;
+    if (ntracked == 0) return;
+    assert(nchecked >= first_tracked);
+
+    double skip_ratio = 1.0 - static_cast<double>(nchecked - first_tracked) /
+                                  static_cast<double>(ntracked);
+    hv_skip_ratio = (1.0 - ADAPTIVE_EWMA_WEIGHT) * hv_skip_ratio +
+                    ADAPTIVE_EWMA_WEIGHT * skip_ratio;
+}
+
+template <typename K, typename V>
+void TxnSiloHV<K, V>::RecheckOneRead() {
+    if (must_abort || no_read_validation || record_list.empty()) return;
+
+    if (recheck_idx >= record_list.size()) recheck_idx = 0;
+    auto&& ritem = record_list[recheck_idx++];
+    if (ritem.repairable) return;
+
+    // a record locked by another writer may still be released unchanged,
+    // so only a committed version change dooms us
+    uint64_t curr_tid = ritem.record->LoadTid();
+    if (Record<K, V>::TidVersion(curr_tid) != ritem.version) {
+        ritem.record->BumpTemperature();
+        must_abort = true;
+    }
+}
+
+template <typename K, typename V>
+bool TxnSiloHV<K, V>::ReadUntracked(Record<K, V>* record, V& value) {
+    V read_value;
+    uint64_t read_tid;
+    if (isolation == ISOLATION_SNAPSHOT) {
+        assert(snap_epoch > 0);
+        bool too_old;
+        read_tid = record->ReadSnapshot(snap_epoch, read_value, too_old);
+        if (too_old) must_abort = true;
     } else
+        read_tid = record->ReadConsistent(read_value);
+    bool valid = Record<K, V>::TidValid(read_tid);
+
+    const size_t* write_idx = write_set.Find(record);
+    if (write_idx == nullptr) {
+        // remember the version seen, which a later write to record builds on
+        if (isolation == ISOLATION_SNAPSHOT && !snap_read_set.Contains(record))
+            snap_read_set.Insert(record, Record<K, V>::TidVersion(read_tid));
+        if (valid) value = std::move(read_value);
+        return valid;
+    }
+
+    // my own write shows through; a pending Merge gets applied on the value
+    // just read, as in ExecReadRecord, so the write now builds on it
+    assert(*write_idx < write_list.size());
+    auto&& witem = write_list[*write_idx];
+    assert(witem.is_record);
+    if (witem.merge) {
+        witem.height_or_value = witem.update(read_value, valid);
+        witem.merge = false;
+        witem.base_version = Record<K, V>::TidVersion(read_tid);
+    }
+    value = std::get<V>(witem.height_or_value);
+    return true;
+}
+
+template <typename K, typename V>
+bool TxnSiloHV<K, V>::ExecReadRecord(Record<K, V>* record, V& value) {
+    // nothing to track, and no read to protect with hot locks
+    if (isolation != ISOLATION_SERIALIZABLE)
+        return ReadUntracked(record, value);
+
+    if (hot_locking && !must_abort) hot_locks.LockIfHot(record, !in_scan);
+
+    // fetch value and version, seqlock-style without writing to record
+    V read_value;
+    uint64_t read_tid = record->ReadConsistent(read_value);
+    bool valid = Record<K, V>::TidValid(read_tid);
+    uint64_t read_version = Record<K, V>::TidVersion(read_tid);
+
+    // if in my local write set, read from there instead; a pending Merge
+    // gets applied on the value just read, which is then tracked as usual
+    const size_t* write_idx = write_set.Find(record);
+    if (write_idx != nullptr) {
+        assert(*write_idx < write_list.size());
+        auto&& witem = write_list[*write_idx];
+        assert(witem.is_record);
+        if (witem.merge) {
+            witem.height_or_value = witem.update(read_value, valid);
+            witem.merge = false;
+        }
+        value = std::get<V>(witem.height_or_value);
+    } else if (valid)
         value = std::move(read_value);
 
-    // insert into read set if not in it yet
-    if (record_set.contains(record)) {
-        assert(record_set[record] < record_list.size());
-        if (record_list[record_set[record]].version != read_version) {
+    // insert into read set if not in it yet; the value now escapes to the
+    // client, so it can no longer be repaired; a phantom record without
+    // filled value reads as absent, but is tracked all the same, so that
+    // another transaction filling it before my commit fails validation
+    const size_t* record_idx = record_set.Find(record);
+    if (record_idx != nullptr) {
+        assert(*record_idx < record_list.size());
+        record_list[*record_idx].repairable = false;
+        if (record_list[*record_idx].version != read_version) {
             // same record read multiple times by the transaction and versions
-            // already mismatch
-            // we could just early abort here, but for simplicity, we save
-            // this decision and abort at finish time
+            // already mismatch; doom the transaction so that subsequent
+            // operations return early, and abort at finish time
+            record->BumpTemperature();
             must_abort = true;
         }
     } else {
         record_list.push_back(
             RecordListItem{.record = record, .version = read_version});
-        record_set[record] = record_list.size() - 1;
+        record_set.Insert(record, record_list.size() - 1);
     }
 
-    return true;
+    return write_idx != nullptr || valid;
 }
 
 template <typename K, typename V>
 void TxnSiloHV<K, V>::ExecWriteRecord(Record<K, V>* record, V value) {
-    // do not actually write; save value locally
-    if (write_set.contains(record)) {
-        assert(write_list[write_set[record]].is_record);
-        write_list[write_set[record]].height_or_value = std::move(value);
+    if (hot_locking && !must_abort) hot_locks.LockIfHot(record, !in_scan);
+
+    // do not actually write; save value locally, which no longer depends on
+    // earlier Updates
+    size_t* write_idx = write_set.Find(record);
+    if (write_idx != nullptr) {
+        assert(write_list[*write_idx].is_record);
+        write_list[*write_idx].height_or_value = std::move(value);
+        write_list[*write_idx].update = nullptr;
+        write_list[*write_idx].merge = false;
     } else {
         write_list.push_back(
             WriteListItem{.is_record = true,
                           .record = record,
-                          .height_or_value = std::move(value)});
-        write_set[record] = write_list.size() - 1;
+                          .height_or_value = std::move(value),
+                          .base_version = BaseVersion(record)});
+        write_set.Insert(record, write_list.size() - 1);
     }
 }
 
 template <typename K, typename V>
-void TxnSiloHV<K, V>::ExecReadTraverseNode(Page<K>* page) {
-    // TODO: only doing skipping for Scans for now
-    if (in_scan) {
-        // if there is a node item at the same height, set its skip_to
-        // TODO: reading root page's height may not be thread-safe
-        unsigned height = page->height;
-        if (last_read_node.contains(height)) {
-            assert(last_read_node[height] < page_list.size());
-            auto&& pitem = page_list[last_read_node[height]];
-            pitem.record_idx_end = record_list.size();
-            pitem.page_skip_to = page_list.size();
-            last_read_node.erase(height);
-        }
+bool TxnSiloHV<K, V>::UpdateOwnWrite(
+    Record<K, V>* record, const typename TxnCxt<K, V>::UpdateFn& fn) {
+    size_t* write_idx = write_set.Find(record);
+    if (write_idx == nullptr) return false;
+    assert(*write_idx < write_list.size());
+
+    // if that write came from Updates or Merges, chain fn onto them so that
+    // a repair or the install re-runs all; a pending Merge has no value yet
+    auto&& witem = write_list[*write_idx];
+    assert(witem.is_record);
+    if (!witem.merge) {
+        V& value = std::get<V>(witem.height_or_value);
+        value = fn(value, true);
+    }
+    if (witem.update) {
+        witem.update = [prev = std::move(witem.update), fn](const V& value,
+                                                            bool found) {
+            return fn(prev(value, found), true);
+        };
+    }
+    return true;
+}
+
+template <typename K, typename V>
+void TxnSiloHV<K, V>::ExecUpdateRecord(
+    Record<K, V>* record, const typename TxnCxt<K, V>::UpdateFn& fn) {
+    // read committed defers the whole Update to the install phase; snapshot
+    // isolation checks every write at commit anyway, so needs no repair
+    if (isolation == ISOLATION_READ_COMMITTED) {
+        ExecMergeRecord(record, fn);
+        return;
+    }
+    if (isolation == ISOLATION_SNAPSHOT) {
+        TxnCxt<K, V>::ExecUpdateRecord(record, fn);
+        return;
+    }
+
+    if (hot_locking && !must_abort) hot_locks.LockIfHot(record, !in_scan);
+
+    // building upon my own write needs no read
+    if (UpdateOwnWrite(record, fn)) return;
 
-        // append to read list if not already in the list pushed by a previous
-        // operation in the same transaction
-        if (!page_set.contains(page)) {
-            page_list.push_back(
-                PageListItem{.page = page,
-                             .version = page->hv_ver,
-                             .record_idx_start = record_list.size(),
-                             .record_idx_end = 0,
-                             .page_skip_to = 0});
-            page_set[page] = page_list.size() - 1;
-            last_read_node[height] = page_list.size() - 1;
+    // unlike plain reads, a phantom record is read as well, since someone
+    // filling it in makes the not-found read stale
+    V read_value;
+    uint64_t read_tid = record->ReadConsistent(read_value);
+    bool valid = Record<K, V>::TidValid(read_tid);
+    uint64_t read_version = Record<K, V>::TidVersion(read_tid);
+
+    const size_t* record_idx = record_set.Find(record);
+    if (record_idx != nullptr) {
+        assert(*record_idx < record_list.size());
+        if (record_list[*record_idx].version != read_version) {
+            record->BumpTemperature();
+            must_abort = true;
+            return;
         }
+    } else {
+        // reached through a write traversal, so the record must not fall into
+        // the skip range of any page open from earlier reads
+        CloseReadNodes(UINT_MAX);
+        record_list.push_back(RecordListItem{
+            .record = record, .version = read_version, .repairable = true});
+        record_set.Insert(record, record_list.size() - 1);
+    }
+
+    write_list.push_back(WriteListItem{.is_record = true,
+                                       .record = record,
+                                       .height_or_value = fn(read_value, valid),
+                                       .update = fn});
+    write_set.Insert(record, write_list.size() - 1);
+}
+
+template <typename K, typename V>
+void TxnSiloHV<K, V>::ExecMergeRecord(
+    Record<K, V>* record, const typename TxnCxt<K, V>::UpdateFn& fn) {
+    // no hot locking, since a Merge never fails validation
+    if (UpdateOwnWrite(record, fn)) return;
+
+    write_list.push_back(WriteListItem{.is_record = true,
+                                       .record = record,
+                                       .height_or_value = V(),
+                                       .update = fn,
+                                       .merge = true,
+                                       .base_version = BaseVersion(record)});
+    write_set.Insert(record, write_list.size() - 1);
+}
+
+template <typename K, typename V>
+bool TxnSiloHV<K, V>::RepairRead(Record<K, V>* record) {
+    // records are sorted by address after all tree nodes
+    auto it = std::lower_bound(
+        write_list.begin(), write_list.end(), record,
+        [](const WriteListItem& witem, const Record<K, V>* r) {
+            return !witem.is_record ||
+                   reinterpret_cast<uint64_t>(witem.record) <
+                       reinterpret_cast<uint64_t>(r);
+        });
+    assert(it != write_list.end() && it->is_record && it->record == record);
+
+    // overwritten by a blind write since; the stale value has still been
+    // seen by the Update functions, which are gone, so cannot repair
+    if (!it->update) return false;
+
+    V value;
+    bool found = record->ReadLocked(value);
+    it->height_or_value = it->update(value, found);
+    DEBUG("record read repaired %p", static_cast<void*>(record));
+    return true;
+}
+
+template <typename K, typename V>
+void TxnSiloHV<K, V>::CloseReadNodes(unsigned height) {
+    if (last_read_node.empty()) return;
+    unsigned max_height = std::min(
+        height, static_cast<unsigned>(last_read_node.size()) - 1);
+    for (unsigned h = 1; h <= max_height; ++h) {
+        size_t idx = last_read_node[h];
+        if (idx == NO_NODE) continue;
+        assert(idx < page_list.size());
+        auto&& pitem = page_list[idx];
+        pitem.record_idx_end = record_list.size();
+        pitem.page_skip_to = page_list.size();
+        last_read_node[h] = NO_NODE;
+    }
+}
+
+template <typename K, typename V>
+void TxnSiloHV<K, V>::ExecReadTraverseNode(Page<K>* page) {
+    if (!track_reads || isolation != ISOLATION_SERIALIZABLE) return;
+
+    // pages above cutoff height are neither tracked nor updated
+    // TODO: reading root page's height may not be thread-safe
+    unsigned height = page->height;
+    if (!HVTracked(height)) return;
+
+    if (last_read_node.size() <= height)
+        last_read_node.resize(height + 1, NO_NODE);
+
+    // still in the subtree of the open node at this height, nothing to do
+    if (last_read_node[height] != NO_NODE &&
+        page_list[last_read_node[height]].page == page)
+        return;
+
+    // diverged from the open nodes at this height and below, since they
+    // cannot be descendants of this page; close their skip ranges
+    CloseReadNodes(height);
+
+    // append to read list if not already in the list pushed by a previous
+    // operation in the same transaction; a page visited again after its
+    // item got closed is not reopened, as the records read in between do not
+    // belong to it
+    if (!page_set.Contains(page)) {
+        page_list.push_back(PageListItem{.page = page,
+                                         .version = page->hv_ver,
+                                         .record_idx_start = record_list.size(),
+                                         .record_idx_end = 0,
+                                         .page_skip_to = 0});
+        page_set.Insert(page, page_list.size() - 1);
+        last_read_node[height] = page_list.size() - 1;
     }
 }
 
 template <typename K, typename V>
 void TxnSiloHV<K, V>::ExecWriteTraverseNode(Page<K>* page, unsigned height) {
+    // pages above cutoff height are neither tracked nor updated
+    if (!HVTracked(height)) return;
+
     // append to write list if not already in the list pushed by a previous
     // operation in the same transaction
-    if (!write_set.contains(page)) {
+    if (!write_set.Contains(page)) {
         write_list.push_back(WriteListItem{
             .is_record = false, .page = page, .height_or_value = height});
-        write_set[page] = write_list.size() - 1;
+        write_set.Insert(page, write_list.size() - 1);
     }
 }
 
 template <typename K, typename V>
-void TxnSiloHV<K, V>::ExecEnterScan() {
-    in_scan = true;
-    assert(last_read_node.empty());
+uint64_t TxnSiloHV<K, V>::BaseVersion(Record<K, V>* record) const {
+    if (isolation != ISOLATION_SNAPSHOT) return 0;
+
+    // a blind write only conflicts with commits after it, not with those
+    // between the snapshot and now, which it never saw
+    const uint64_t* read_version = snap_read_set.Find(record);
+    if (read_version != nullptr) return *read_version;
+    return Record<K, V>::TidVersion(record->LoadTid());
 }
 
 template <typename K, typename V>
-void TxnSiloHV<K, V>::ExecLeaveScan() {
-    in_scan = false;
-    // set dangling node items' skip_to
-    for (auto&& [_, idx] : last_read_node) {
-        assert(idx < page_list.size());
-        auto&& pitem = page_list[idx];
-        pitem.record_idx_end = record_list.size();
-        pitem.page_skip_to = page_list.size();
+bool TxnSiloHV<K, V>::WritesInSnapshot() const {
+    for (auto&& witem : write_list) {
+        // a Merge does not depend on the value it overwrites
+        if (!witem.is_record || witem.merge) continue;
+
+        // I hold the lock, so this is the latest committed version
+        uint64_t curr_tid = witem.record->LoadTid();
+        if (Record<K, V>::TidVersion(curr_tid) != witem.base_version)
+            return false;
     }
-    last_read_node.clear();
+    return true;
+}
+
+template <typename K, typename V>
+void TxnSiloHV<K, V>::ExecObserveLeaf(Page<K>* leaf) {
+    // phantoms are only prevented at ISOLATION_SERIALIZABLE
+    if (isolation != ISOLATION_SERIALIZABLE) return;
+
+    // leaf got a new key or split since I first observed it
+    if (!node_set.Observe(leaf)) must_abort = true;
+}
+
+template <typename K, typename V>
+void TxnSiloHV<K, V>::ExecInsertIntoLeaf(Page<K>* leaf,
+                                         uint64_t old_node_ver,
+                                         Page<K>* split_lpage,
+                                         Page<K>* split_rpage) {
+    node_set.Inserted(leaf, old_node_ver, split_lpage, split_rpage);
+}
+
+template <typename K, typename V>
+bool TxnSiloHV<K, V>::ValidateRecords(size_t begin, size_t end) {
+    assert(begin <= end && end <= record_list.size());
+    return ValidateReadBatches(
+        record_list.begin() + begin, record_list.begin() + end,
+        [&](Record<K, V>* record) { return write_set.Contains(record); },
+        [&](Record<K, V>* record) { return RepairRead(record); });
 }
 
 template <typename K, typename V>
 bool TxnSiloHV<K, V>::TryCommit(std::atomic<uint64_t>* ser_counter,
                                 uint64_t* ser_order, TxnStats* stats) {
-    if (must_abort) return false;
+    if (must_abort) {
+        hot_locks.ReleaseAll();
+        return false;
+    }
+
+    // set dangling node items' skip ranges
+    CloseReadNodes(UINT_MAX);
 
     std::chrono::time_point<std::chrono::high_resolution_clock> start_tp;
     if constexpr (build_options.txn_stat)
@@ -157,11 +456,11 @@ bool TxnSiloHV<K, V>::TryCommit(std::atomic<uint64_t>* ser_counter,
 
     for (auto&& witem : write_list) {
         if (witem.is_record) {
-            witem.record->latch.lock();
+            witem.record->Lock();
             DEBUG("record latch W acquire %p",
                   static_cast<void*>(witem.record));
         } else {
-            ++witem.page->hv_sem;
+            witem.page->HoldHVSem();
             DEBUG("page hv_sem increment %p", static_cast<void*>(witem.page));
         }
     }
@@ -169,62 +468,62 @@ bool TxnSiloHV<K, V>::TryCommit(std::atomic<uint64_t>* ser_counter,
     auto release_all_write_latches = [&]() {
         for (auto&& witem : write_list) {
             if (witem.is_record) {
-                witem.record->latch.unlock();
+                witem.record->Unlock();
                 DEBUG("record latch W release %p",
                       static_cast<void*>(witem.record));
             } else {
-                --witem.page->hv_sem;
+                witem.page->ReleaseHVSem();
                 DEBUG("page hv_sem decrement %p",
                       static_cast<void*>(witem.page));
             }
         }
+        hot_locks.ReleaseAll();
     };
 
+    // a record locked by a hot-record holder must not change under it
+    if (hot_locking) {
+        for (auto&& witem : write_list) {
+            if (witem.is_record && !hot_locks.MayInstall(witem.record)) {
+                witem.record->BumpTemperature();
+                release_all_write_latches();
+                return false;
+            }
+        }
+    }
+
     std::chrono::time_point<std::chrono::high_resolution_clock> end_lock_tp;
     if constexpr (build_options.txn_stat)
         end_lock_tp = std::chrono::high_resolution_clock::now();
 
+    // stay in an epoch critical section until all writes are installed, so
+    // that the global epoch cannot move two past my commit TID's epoch
+    // before then; snapshot reads rely on this
+    EpochGuard epoch_guard;
+
     // <-- serialization point -->
     if (ser_counter != nullptr && ser_order != nullptr)
         *ser_order = (*ser_counter)++;
 
-    // phase 2
-    auto validate_record = [this](const RecordListItem& ritem) {
-        bool latched = false;
-        bool me_writing = write_set.contains(ritem.record);
-        if (!me_writing) {
-            latched = ritem.record->latch.try_lock_shared();
-            DEBUG("record latch R try_acquire %p %s",
-                  static_cast<void*>(ritem.record), latched ? "yes" : "no");
-            if (!latched) {
-                return false;
-            }
-        }
+    // generate commit TID from current epoch and worker-local sequence
+    uint64_t new_version = EpochManager::Global().NewCommitTid();
 
-        // if version mismatch, abort
-        if (!me_writing && !latched) {
-            ritem.record->latch.lock_shared();
-            DEBUG("record latch R acquire %p",
-                  static_cast<void*>(ritem.record));
-        }
-        uint64_t curr_version = ritem.record->version;
-        if (!me_writing) {
-            ritem.record->latch.unlock_shared();
-            DEBUG("record latch R release %p",
-                  static_cast<void*>(ritem.record));
-        }
-
-        if (ritem.version != curr_version) {
-            return false;
-        }
-
-        return true;
-    };
+    // under snapshot isolation, the first committer to a record wins; the
+    // read lists and node set are empty then, so phase 2 below is a no-op
+    if (isolation == ISOLATION_SNAPSHOT && !WritesInSnapshot()) {
+        release_all_write_latches();
+        return false;
+    }
 
+    // phase 2
     auto validate_page = [this](const PageListItem& pitem) {
+        // a root page that grew above cutoff height since read, after which
+        // writers no longer update it, got a fresh hv_ver on its split, so
+        // the version check below falls back to its children; its height
+        // must not be read here without a latch
+
         // check semaphore field of tree page
-        uint64_t hv_sem = pitem.page->hv_sem;
-        if (hv_sem > 1 || (hv_sem == 1 && !write_set.contains(pitem.page))) {
+        uint64_t hv_sem = pitem.page->LoadHVSem();
+        if (hv_sem > 1 || (hv_sem == 1 && !write_set.Contains(pitem.page))) {
             return false;
         }
 
@@ -239,18 +538,31 @@ bool TxnSiloHV<K, V>::TryCommit(std::atomic<uint64_t>* ser_counter,
     if (!no_read_validation) {
         size_t page_idx = 0;
         size_t record_idx = 0;
+        size_t nchecked = 0;
+
+        for (size_t i = 0; i < std::min(PAGE_PREFETCH_DIST, page_list.size());
+             ++i)
+            page_list[i].page->PrefetchHV();
 
         // iterate through all page nodes
         while (page_idx < page_list.size()) {
             auto&& pitem = page_list[page_idx];
 
+            // the next page is either the one after, or where this page's
+            // skip range ends; keep both ahead in the cache
+            if (page_idx + PAGE_PREFETCH_DIST < page_list.size())
+                page_list[page_idx + PAGE_PREFETCH_DIST].page->PrefetchHV();
+            if (pitem.page_skip_to < page_list.size())
+                page_list[pitem.page_skip_to].page->PrefetchHV();
+
             // validate records between record_idx and page's start record idx
-            for (; record_idx < pitem.record_idx_start; record_idx++) {
-                assert(record_idx < record_list.size());
-                if (!validate_record(record_list[record_idx])) {
+            if (record_idx < pitem.record_idx_start) {
+                if (!ValidateRecords(record_idx, pitem.record_idx_start)) {
                     release_all_write_latches();
                     return false;
                 }
+                nchecked += pitem.record_idx_start - record_idx;
+                record_idx = pitem.record_idx_start;
             }
 
             // validate the page
@@ -268,12 +580,19 @@ bool TxnSiloHV<K, V>::TryCommit(std::atomic<uint64_t>* ser_counter,
         }
 
         // we are done validating all pages, validate the rest of records
-        for (; record_idx < record_list.size(); record_idx++) {
-            assert(record_idx < record_list.size());
-            if (!validate_record(record_list[record_idx])) {
+        if (record_idx < record_list.size()) {
+            if (!ValidateRecords(record_idx, record_list.size())) {
                 release_all_write_latches();
                 return false;
             }
+            nchecked += record_list.size() - record_idx;
+        }
+        AdaptRecordSkips(nchecked);
+
+        // if any observed leaf got new keys or split, abort due to phantoms
+        if (!node_set.Validate()) {
+            release_all_write_latches();
+            return false;
         }
     }
 
@@ -281,40 +600,27 @@ bool TxnSiloHV<K, V>::TryCommit(std::atomic<uint64_t>* ser_counter,
     if constexpr (build_options.txn_stat)
         end_validate_tp = std::chrono::high_resolution_clock::now();
 
-    // generate new version number, one greater than all versions seen by
-    // this transaction
-    uint64_t new_version = 0;
-    for (auto&& ritem : record_list)
-        if (ritem.version > new_version) new_version = ritem.version;
-    for (auto&& pitem : page_list)
-        if (pitem.version > new_version) new_version = pitem.version;
+    // phase 3: reflect writes with new version number, applying Merges on
+    // the latest values under the locks
     for (auto&& witem : write_list) {
         if (witem.is_record) {
-            if (witem.record->version > new_version)
-                new_version = witem.record->version;
-        } else {
-            uint64_t hv_ver = witem.page->hv_ver;
-            if (hv_ver > new_version) new_version = hv_ver;
-        }
-    }
-    new_version++;
-
-    // phase 3: reflect writes with new version number
-    for (auto&& witem : write_list) {
-        if (witem.is_record) {
-            witem.record->value = std::move(std::get<V>(witem.height_or_value));
-            witem.record->version = new_version;
-            witem.record->valid = true;
-
-            witem.record->latch.unlock();
+            if (witem.merge) {
+                V value;
+                bool found = witem.record->ReadLocked(value);
+                witem.height_or_value = witem.update(value, found);
+            }
+            witem.record->InstallValue(
+                std::move(std::get<V>(witem.height_or_value)), new_version);
+            witem.record->UnlockWithVersion(new_version);
             DEBUG("record latch W release %p",
                   static_cast<void*>(witem.record));
         } else {
             witem.page->hv_ver = new_version;
-            --witem.page->hv_sem;
+            witem.page->ReleaseHVSem();
             DEBUG("page hv_sem decrement %p", static_cast<void*>(witem.page));
         }
     }
+    hot_locks.ReleaseAll();
 
     std::chrono::time_point<std::chrono::high_resolution_clock> end_commit_tp;
     if constexpr (build_options.txn_stat)
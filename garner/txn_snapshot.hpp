@@ -0,0 +1,123 @@
+// TxnSnapshot -- read-only context reading from a consistent snapshot.
+
+#include <atomic>
+#include <iostream>
+
+#include "build_options.hpp"
+#include "common.hpp"
+#include "epoch.hpp"
+#include "page.hpp"
+#include "record.hpp"
+#include "txn.hpp"
+
+#pragma once
+
+namespace garner {
+
+/**
+ * Snapshot read-only transaction context type, usable under any OCC
+ * protocol. Similar to Silo's snapshot transactions.
+ *
+ * Upon its first read, the transaction picks the snapshot epoch as one
+ * less than the current global epoch, and from then on reads from every
+ * record the newest version committed in an epoch before that. Committing
+ * writers stay in an epoch critical section from taking their commit TID
+ * until they have installed all their writes, so the global epoch is at
+ * most one past the epoch of any writer still installing. Hence, all
+ * versions from epochs before the snapshot epoch are in place by the time
+ * it is picked. Since epochs of dependent transactions never decrease along
+ * the serialization order, that set of versions is a consistent state of
+ * the database, and nothing needs to be validated at commit.
+ *
+ * Keys inserted after the snapshot have no visible version and are skipped,
+ * so no phantom tracking is needed either. The only way to abort is to ask
+ * for a version that has been pruned from a record's bounded chain.
+ */
+template <typename K, typename V>
+class TxnSnapshot : public TxnCxt<K, V> {
+   private:
+    // versions from epochs before this are visible, 0 if not picked yet
+    uint64_t snap_epoch = 0;
+
+    // true if a needed version has already been pruned
+    bool must_abort = false;
+
+    /**
+     * Pick the snapshot epoch if not picked yet.
+     */
+    void PickSnapshot();
+
+   public:
+    TxnSnapshot() : TxnCxt<K, V>(), snap_epoch(0), must_abort(false) {}
+
+    TxnSnapshot(const TxnSnapshot&) = delete;
+    TxnSnapshot& operator=(const TxnSnapshot&) = delete;
+
+    ~TxnSnapshot() = default;
+
+    /**
+     * Forget the snapshot for recycling.
+     */
+    void Reset();
+
+    /**
+     * Set value to the record's value in the snapshot. Returns false if the
+     * record has no version in the snapshot.
+     */
+    bool ExecReadRecord(Record<K, V>* record, V& value);
+
+    /**
+     * Never called, since GarnerImpl rejects writes in read-only
+     * transactions before touching the tree.
+     */
+    void ExecWriteRecord(Record<K, V>* record, V value);
+
+    /**
+     * Pick the snapshot upon the first read operation.
+     */
+    void ExecEnterGet() { PickSnapshot(); }
+    void ExecEnterScan() { PickSnapshot(); }
+
+    /**
+     * Not used.
+     */
+    void ExecReadTraverseNode([[maybe_unused]] Page<K>* page) {}
+    void ExecWriteTraverseNode([[maybe_unused]] Page<K>* page,
+                               [[maybe_unused]] unsigned height) {}
+    void ExecObserveLeaf([[maybe_unused]] Page<K>* leaf) {}
+    void ExecInsertIntoLeaf([[maybe_unused]] Page<K>* leaf,
+                            [[maybe_unused]] uint64_t old_node_ver,
+                            [[maybe_unused]] Page<K>* split_lpage,
+                            [[maybe_unused]] Page<K>* split_rpage) {}
+    void ExecEnterPut() {}
+    void ExecLeavePut() {}
+    void ExecLeaveGet() {}
+    void ExecEnterDelete() {}
+    void ExecLeaveDelete() {}
+    void ExecLeaveScan() {}
+
+    bool IsDoomed() const { return must_abort; }
+    TxnMode Mode() const { return TXN_SNAPSHOT; }
+
+    /**
+     * Nothing to validate; commits unless a needed version was pruned.
+     */
+    bool TryCommit(std::atomic<uint64_t>* ser_counter = nullptr,
+                   uint64_t* ser_order = nullptr, TxnStats* stats = nullptr);
+
+    template <typename KK, typename VV>
+    friend std::ostream& operator<<(std::ostream& s,
+                                    const TxnSnapshot<KK, VV>& txn);
+};
+
+template <typename K, typename V>
+std::ostream& operator<<(std::ostream& s, const TxnSnapshot<K, V>& txn) {
+    s << "TxnSnapshot{snap_epoch=" << txn.snap_epoch
+      << ",must_abort=" << txn.must_abort << "}";
+    return s;
+}
+
+}  // namespace garner
+
+// Include template implementation in-place.
+#include "txn_snapshot.tpl.hpp"
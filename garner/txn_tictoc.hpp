@@ -0,0 +1,185 @@
+// TxnTicToc -- TicToc timestamp-based optimistic concurrency control.
+
+#include <algorithm>
+#include <atomic>
+#include <iostream>
+#include <vector>
+
+#include "build_options.hpp"
+#include "common.hpp"
+#include "epoch.hpp"
+#include "node_set.hpp"
+#include "page.hpp"
+#include "record.hpp"
+#include "small_map.hpp"
+#include "txn.hpp"
+
+#pragma once
+
+namespace garner {
+
+/**
+ * TicToc transaction context type.
+ * https://dl.acm.org/doi/10.1145/2882903.2882935
+ *
+ * Each record version carries the logical interval [wts, rts] during which
+ * it is known valid. Instead of a global serialization point, the commit
+ * timestamp is computed from the data accessed: no earlier than the wts of
+ * every version read, and later than the rts of every record written. Reads
+ * then only fail validation if they cannot be extended to the commit
+ * timestamp, so a read-modify-write racing a reader no longer aborts it.
+ *
+ * Phantoms are handled by treating each observed leaf as a read: its
+ * tictoc_rts gets extended to the commit timestamp before its node version
+ * is validated, and an inserter commits after the rts of the leaf it
+ * inserted into.
+ *
+ * Read-only and snapshot modes run the same protocol with writes rejected,
+ * since OCC read-only validation relies on commit order matching TID order,
+ * which does not hold here.
+ */
+template <typename K, typename V>
+class TxnTicToc : public TxnCxt<K, V> {
+   private:
+    // commit timestamp of this thread's last committed transaction or
+    // autocommit write; later ones never commit earlier, so that each
+    // thread's writes take effect in program order (autocommit Gets take no
+    // timestamp and are not ordered this way)
+    static thread_local uint64_t thread_last_commit_ts;
+
+    // read list storing record -> timestamps of the version read
+    struct RecordListItem {
+        Record<K, V>* record;
+        uint64_t wts;
+        uint64_t rts;
+    };
+
+    std::vector<RecordListItem> read_vec;
+
+    // read set storing record -> index in read_vec
+    SmallMap<Record<K, V>*, size_t, 16> read_set;
+
+    // write list storing record -> new value, sorted by record address at
+    // commit time for deadlock-free locking
+    struct WriteListItem {
+        Record<K, V>* record;
+        V value;
+    };
+
+    std::vector<WriteListItem> write_vec;
+
+    // write set storing record -> index in write_vec
+    SmallMap<Record<K, V>*, size_t, 16> write_set;
+
+    // leaf node versions observed by negative lookups and scans, for
+    // detecting phantoms
+    NodeSet<K> node_set;
+
+    // lower bound of commit timestamp imposed by leaves I inserted into
+    uint64_t min_commit_ts = 0;
+
+    // access mode; writes are rejected unless TXN_READ_WRITE
+    const TxnMode mode = TXN_READ_WRITE;
+
+    // true if abort decision already made during execution
+    bool must_abort = false;
+
+   public:
+    TxnTicToc(TxnMode mode = TXN_READ_WRITE)
+        : TxnCxt<K, V>(),
+          read_vec(),
+          read_set(),
+          write_vec(),
+          write_set(),
+          node_set(),
+          min_commit_ts(0),
+          mode(mode),
+          must_abort(false) {}
+
+    TxnTicToc(const TxnTicToc&) = delete;
+    TxnTicToc& operator=(const TxnTicToc&) = delete;
+
+    /**
+     * Commit timestamp of this thread's last TicToc commit, which autocommit
+     * writes under TicToc respect and advance as well.
+     */
+    static uint64_t& ThreadLastCommitTs() { return thread_last_commit_ts; }
+
+    ~TxnTicToc() = default;
+
+    /**
+     * Clear read/write sets for recycling, keeping their capacity.
+     */
+    void Reset();
+
+    /**
+     * Save record to read set with timestamps of the version read, set value
+     * to its current read value. Returns true if read is successful, or
+     * false if reading a phantom record inserted by some other transaction
+     * without filled value; such a record is kept in the read set as well,
+     * so that its inserter commits after me.
+     */
+    bool ExecReadRecord(Record<K, V>* record, V& value);
+
+    /**
+     * Save record to write set and locally remember attempted write value.
+     */
+    void ExecWriteRecord(Record<K, V>* record, V value);
+
+    /**
+     * Save leaf to node set with its current node version.
+     */
+    void ExecObserveLeaf(Page<K>* leaf);
+
+    /**
+     * Follow node version bumps caused by my own insertion into leaf, and
+     * make sure to commit after those who observed its key range.
+     */
+    void ExecInsertIntoLeaf(Page<K>* leaf, uint64_t old_node_ver,
+                            Page<K>* split_lpage, Page<K>* split_rpage);
+
+    /**
+     * Not used.
+     */
+    void ExecReadTraverseNode([[maybe_unused]] Page<K>* page) {}
+    void ExecWriteTraverseNode([[maybe_unused]] Page<K>* page,
+                               [[maybe_unused]] unsigned height) {}
+    void ExecEnterPut() {}
+    void ExecLeavePut() {}
+    void ExecEnterGet() {}
+    void ExecLeaveGet() {}
+    void ExecEnterDelete() {}
+    void ExecLeaveDelete() {}
+    void ExecEnterScan() {}
+    void ExecLeaveScan() {}
+
+    bool IsDoomed() const { return must_abort; }
+    TxnMode Mode() const { return mode; }
+
+    /**
+     * TicToc validation and commit protocol. The serialization order given
+     * out is by commit timestamp, with ties broken by commit order.
+     */
+    bool TryCommit(std::atomic<uint64_t>* ser_counter = nullptr,
+                   uint64_t* ser_order = nullptr, TxnStats* stats = nullptr);
+
+    template <typename KK, typename VV>
+    friend std::ostream& operator<<(std::ostream& s,
+                                    const TxnTicToc<KK, VV>& txn);
+};
+
+template <typename K, typename V>
+std::ostream& operator<<(std::ostream& s, const TxnTicToc<K, V>& txn) {
+    s << "TxnTicToc{read_vec=[";
+    for (auto&& [r, wts, rts] : txn.read_vec)
+        s << "(" << r << "-" << wts << "-" << rts << "),";
+    s << "],write_set=[";
+    for (auto&& [r, val] : txn.write_vec) s << "(" << r << "-" << val << "),";
+    s << "],must_abort=" << txn.must_abort << "}";
+    return s;
+}
+
+}  // namespace garner
+
+// Include template implementation in-place.
+#include "txn_tictoc.tpl.hpp"
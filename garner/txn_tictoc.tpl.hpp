@@ -0,0 +1,218 @@
+// Template implementation included in-place by the ".hpp".
+
+#pragma once
+
+namespace garner {
+
+template <typename K, typename V>
+thread_local uint64_t TxnTicToc<K, V>::thread_last_commit_ts = 0;
+
+template <typename K, typename V>
+void TxnTicToc<K, V>::Reset() {
+    read_vec.clear();
+    read_set.Clear();
+    write_vec.clear();
+    write_set.Clear();
+    node_set.Clear();
+    min_commit_ts = 0;
+    must_abort = false;
+}
+
+template <typename K, typename V>
+bool TxnTicToc<K, V>::ExecReadRecord(Record<K, V>* record, V& value) {
+    const size_t* read_idx = read_set.Find(record);
+
+    // if in my local write set, read from there instead
+    const size_t* write_idx = write_set.Find(record);
+    if (write_idx != nullptr && read_idx == nullptr) {
+        assert(*write_idx < write_vec.size());
+        value = write_vec[*write_idx].value;
+        return true;
+    }
+
+    // fetch value and timestamps, seqlock-style without writing to record
+    V read_value;
+    uint64_t word;
+    uint64_t read_tid = record->ReadConsistentTicToc(read_value, word);
+    bool valid = Record<K, V>::TidValid(read_tid);
+    uint64_t wts = Record<K, V>::TicTocWts(word);
+
+    if (read_idx != nullptr) {
+        assert(*read_idx < read_vec.size());
+        // same record read multiple times and versions already mismatch
+        if (read_vec[*read_idx].wts != wts) must_abort = true;
+    } else {
+        read_vec.push_back(
+            RecordListItem{.record = record,
+                           .wts = wts,
+                           .rts = Record<K, V>::TicTocRts(word)});
+        read_set.Insert(record, read_vec.size() - 1);
+    }
+
+    if (write_idx != nullptr) {
+        assert(*write_idx < write_vec.size());
+        value = write_vec[*write_idx].value;
+        return true;
+    }
+    if (!valid) return false;
+    value = std::move(read_value);
+    return true;
+}
+
+template <typename K, typename V>
+void TxnTicToc<K, V>::ExecWriteRecord(Record<K, V>* record, V value) {
+    if (mode != TXN_READ_WRITE)
+        throw GarnerException("write attempted in read-only transaction");
+
+    // do not actually write; save value locally
+    size_t* write_idx = write_set.Find(record);
+    if (write_idx != nullptr) {
+        assert(*write_idx < write_vec.size());
+        write_vec[*write_idx].value = std::move(value);
+    } else {
+        write_vec.push_back(
+            WriteListItem{.record = record, .value = std::move(value)});
+        write_set.Insert(record, write_vec.size() - 1);
+    }
+}
+
+template <typename K, typename V>
+void TxnTicToc<K, V>::ExecObserveLeaf(Page<K>* leaf) {
+    // leaf got a new key or split since I first observed it
+    if (!node_set.Observe(leaf)) must_abort = true;
+}
+
+template <typename K, typename V>
+void TxnTicToc<K, V>::ExecInsertIntoLeaf(Page<K>* leaf, uint64_t old_node_ver,
+                                         Page<K>* split_lpage,
+                                         Page<K>* split_rpage) {
+    // pairs with the fence between extending leaf rts and validating node
+    // version at commit: either the observer sees my insertion, or I see
+    // its extended rts
+    std::atomic_thread_fence(std::memory_order_seq_cst);
+    for (Page<K>* page : {leaf, split_lpage, split_rpage}) {
+        if (page == nullptr) continue;
+        min_commit_ts =
+            std::max(min_commit_ts,
+                     page->tictoc_rts.load(std::memory_order_relaxed) + 1);
+    }
+
+    node_set.Inserted(leaf, old_node_ver, split_lpage, split_rpage);
+}
+
+template <typename K, typename V>
+bool TxnTicToc<K, V>::TryCommit(std::atomic<uint64_t>* ser_counter,
+                                uint64_t* ser_order, TxnStats* stats) {
+    if (must_abort) return false;
+
+    std::chrono::time_point<std::chrono::high_resolution_clock> start_tp;
+    if constexpr (build_options.txn_stat)
+        start_tp = std::chrono::high_resolution_clock::now();
+
+    // phase 1: lock timestamp words for writes in memory address order
+    std::sort(write_vec.begin(), write_vec.end(),
+              [](const WriteListItem& wa, const WriteListItem& wb) {
+                  return reinterpret_cast<uint64_t>(wa.record) <
+                         reinterpret_cast<uint64_t>(wb.record);
+              });
+
+    // compute commit timestamp from the data accessed
+    uint64_t commit_ts = std::max(min_commit_ts, thread_last_commit_ts);
+    for (auto&& [record, _] : write_vec) {
+        uint64_t word = record->LockTicToc();
+        commit_ts = std::max(commit_ts, Record<K, V>::TicTocRts(word) + 1);
+    }
+    for (auto&& ritem : read_vec) commit_ts = std::max(commit_ts, ritem.wts);
+
+    auto release_all_write_locks = [&]() {
+        for (auto&& [record, _] : write_vec) record->UnlockTicToc();
+    };
+
+    std::chrono::time_point<std::chrono::high_resolution_clock> end_lock_tp;
+    if constexpr (build_options.txn_stat)
+        end_lock_tp = std::chrono::high_resolution_clock::now();
+
+    // phase 2: validate reads, extending their versions' rts up to commit
+    // timestamp where needed
+    for (auto&& ritem : read_vec) {
+        if (write_set.Contains(ritem.record)) {
+            // locked by me, only check it was not overwritten since
+            uint64_t word = ritem.record->LoadTicToc();
+            if (Record<K, V>::TicTocWts(word) != ritem.wts) {
+                release_all_write_locks();
+                return false;
+            }
+        } else if (ritem.rts < commit_ts) {
+            if (!ritem.record->ExtendTicTocRts(ritem.wts, commit_ts)) {
+                release_all_write_locks();
+                return false;
+            }
+        }
+    }
+
+    // extend observed leaves' rts, then check that they got no new keys
+    for (auto&& nitem : node_set) {
+        uint64_t rts = nitem.page->tictoc_rts.load(std::memory_order_relaxed);
+        while (rts < commit_ts &&
+               !nitem.page->tictoc_rts.compare_exchange_weak(rts, commit_ts))
+            ;
+    }
+    std::atomic_thread_fence(std::memory_order_seq_cst);
+    if (!node_set.Validate()) {
+        release_all_write_locks();
+        return false;
+    }
+
+    std::chrono::time_point<std::chrono::high_resolution_clock> end_validate_tp;
+    if constexpr (build_options.txn_stat)
+        end_validate_tp = std::chrono::high_resolution_clock::now();
+
+    // stay in an epoch critical section until all writes are installed, as
+    // value reclamation relies on it
+    EpochGuard epoch_guard;
+
+    // <-- serialization point -->
+    // equivalent serial order is by commit timestamp; a transaction reading
+    // a version at the same timestamp as its writer commits after it
+    if (ser_counter != nullptr && ser_order != nullptr)
+        *ser_order = (commit_ts << 32) | ((*ser_counter)++ & 0xFFFFFFFFUL);
+    thread_last_commit_ts = commit_ts;
+
+    // phase 3: reflect writes; the TID word keeps a Silo-style version for
+    // autocommit readers
+    uint64_t new_version = EpochManager::Global().NewCommitTid();
+    for (auto&& [record, value] : write_vec) {
+        record->Lock();
+        DEBUG("record latch W acquire %p", static_cast<void*>(record));
+        record->InstallValue(std::move(value), new_version);
+        record->UnlockWithVersion(new_version);
+        DEBUG("record latch W release %p", static_cast<void*>(record));
+        record->UnlockTicTocWithTs(commit_ts);
+    }
+
+    std::chrono::time_point<std::chrono::high_resolution_clock> end_commit_tp;
+    if constexpr (build_options.txn_stat)
+        end_commit_tp = std::chrono::high_resolution_clock::now();
+
+    // record latency breakdown in microseconds
+    if constexpr (build_options.txn_stat) {
+        if (stats != nullptr) {
+            stats->lock_time =
+                std::chrono::duration_cast<std::chrono::microseconds>(
+                    end_lock_tp - start_tp)
+                    .count();
+            stats->validate_time =
+                std::chrono::duration_cast<std::chrono::microseconds>(
+                    end_validate_tp - end_lock_tp)
+                    .count();
+            stats->commit_time =
+                std::chrono::duration_cast<std::chrono::microseconds>(
+                    end_commit_tp - end_validate_tp)
+                    .count();
+        }
+    }
+
+    return true;
+}
+
+}  // namespace garner
@@ -0,0 +1,186 @@
+#!/usr/bin/env python3
+import matplotlib
+
+matplotlib.use("Agg")
+
+import argparse
+import subprocess
+import matplotlib.pyplot as plt
+
+from simple_bench import simple_bench_path
+
+
+def run_sweep(
+    scan_percentages,
+    hv_heights,
+    output_prefix,
+    degree,
+    num_threads,
+    num_warmup_ops,
+    write_percentage,
+    scan_range,
+):
+    print("Running HV cutoff height sweep...")
+    print(
+        f" degree={degree}  #threads={num_threads}  #warmup={num_warmup_ops}  scan_range={'uniform' if scan_range == 0 else scan_range}"
+    )
+    for scan_percentage in scan_percentages:
+        for hv_height in hv_heights:
+            output_filename = f"{output_prefix}-v{hv_height}-c{scan_percentage}.log"
+            with open(output_filename, "w") as output_file:
+                options = [
+                    "-p",
+                    "silo_hv",
+                    "-v",
+                    str(hv_height),
+                    "-c",
+                    str(scan_percentage),
+                    "-d",
+                    str(degree),
+                    "-t",
+                    str(num_threads),
+                    "-w",
+                    str(num_warmup_ops),
+                    "-r",
+                    str(write_percentage),
+                    "-s",
+                    str(scan_range),
+                ]
+                print(f" Running:  scan {scan_percentage:3d}%  cutoff {hv_height:2d}")
+                subprocess.run(
+                    [simple_bench_path(False)] + options,
+                    check=True,
+                    stderr=subprocess.STDOUT,
+                    stdout=output_file,
+                )
+
+
+def parse_results(scan_percentages, hv_heights, output_prefix):
+    print("Parsing sweep results...")
+    results = {}
+    for scan_percentage in scan_percentages:
+        results[scan_percentage] = {}
+        for hv_height in hv_heights:
+            result_filename = f"{output_prefix}-v{hv_height}-c{scan_percentage}.log"
+            with open(result_filename, "r") as result_file:
+                abort_rates, throughputs = [], []
+                for line in result_file.readlines():
+                    line = line.strip()
+                    if line.startswith("Abort rate:"):
+                        abort_rate = float(line[line.index("(") + 1 : line.index("%")])
+                        abort_rates.append(abort_rate)
+                    elif line.startswith("Throughput:"):
+                        throughput = float(
+                            line[line.index(":") + 1 : line.index("txns/sec")]
+                        )
+                        throughputs.append(throughput)
+
+                assert len(abort_rates) == len(throughputs)
+                assert len(throughputs) > 0
+
+                avg_abort_rate = sum(abort_rates) / len(abort_rates)
+                avg_throughput = sum(throughputs) / len(throughputs)
+                print(
+                    f" Result:  scan {scan_percentage:3d}%  cutoff {hv_height:2d}"
+                    f"  abort {avg_abort_rate:4.1f}%  {avg_throughput:10.2f} txns/sec"
+                )
+                results[scan_percentage][hv_height] = {
+                    "abort_rate": avg_abort_rate,
+                    "throughput": avg_throughput,
+                }
+
+    return results
+
+
+def plot_results(scan_percentages, hv_heights, results, output_prefix):
+    plt.rcParams.update({"font.size": 18})
+
+    # cutoff 0 means tracking from root, which is plotted rightmost
+    xs = list(range(len(hv_heights)))
+    xlabels = ["root" if h == 0 else str(h) for h in hv_heights]
+
+    for metric, ylabel, scale in (
+        ("throughput", "Throughput (x1000 txns/sec)", 1000.0),
+        ("abort_rate", "Abort rate (%)", 1.0),
+    ):
+        for scan_percentage in scan_percentages:
+            ys = [
+                results[scan_percentage][h][metric] / scale for h in hv_heights
+            ]
+            plt.plot(xs, ys, marker="o", label=f"scan {scan_percentage}%")
+
+        plt.xticks(xs, xlabels)
+        plt.ylabel(ylabel)
+        plt.xlabel("HV cutoff height")
+        plt.legend()
+        plt.tight_layout()
+
+        plt.savefig(f"{output_prefix}-{metric}-plot.png", dpi=200)
+        plt.close()
+
+
+if __name__ == "__main__":
+    parser = argparse.ArgumentParser()
+    parser.add_argument("-o", "--output_prefix", dest="output_prefix", required=True)
+    parser.add_argument("-d", "--degree", dest="degree", type=int, default=256)
+    parser.add_argument("-t", "--num_threads", dest="num_threads", type=int, default=16)
+    parser.add_argument(
+        "-w", "--num_warmup_ops", dest="num_warmup_ops", type=int, default=50000
+    )
+    parser.add_argument(
+        "-r", "--write_percentage", dest="write_percentage", type=int, default=10
+    )
+    parser.add_argument("-s", "--scan_range", dest="scan_range", type=int, default=0)
+    parser.add_argument(
+        "-v",
+        "--hv_heights",
+        dest="hv_heights",
+        type=int,
+        nargs="+",
+        default=[1, 2, 3, 0],
+        help="List of HV cutoff heights to try, 0 means from root",
+    )
+    parser.add_argument(
+        "scan_percentages",
+        metavar="C",
+        type=int,
+        nargs="+",
+        help="List of scan percentages to try",
+    )
+    args = parser.parse_args()
+
+    if args.num_threads <= 0:
+        print(f"Error: invalid #threads {args.num_threads}")
+        exit(1)
+    if args.degree <= 1:
+        print(f"Error: invalid tree degree {args.degree}")
+        exit(1)
+    for hv_height in args.hv_heights:
+        if hv_height < 0:
+            print(f"Error: invalid HV cutoff height {hv_height}")
+            exit(1)
+    for scan_percentage in args.scan_percentages:
+        if scan_percentage < 0 or scan_percentage + args.write_percentage > 100:
+            print(f"Error: invalid scan percentage {scan_percentage}")
+            exit(1)
+
+    sorted_scan_percentages = sorted(args.scan_percentages)
+    # keep "from root" as the last point
+    sorted_hv_heights = sorted(h for h in args.hv_heights if h > 0)
+    if 0 in args.hv_heights:
+        sorted_hv_heights.append(0)
+
+    run_sweep(
+        sorted_scan_percentages,
+        sorted_hv_heights,
+        args.output_prefix,
+        args.degree,
+        args.num_threads,
+        args.num_warmup_ops,
+        args.write_percentage,
+        args.scan_range,
+    )
+    results = parse_results(
+        sorted_scan_percentages, sorted_hv_heights, args.output_prefix
+    )
+    plot_results(sorted_scan_percentages, sorted_hv_heights, results, args.output_prefix)
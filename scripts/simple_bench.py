@@ -11,7 +11,15 @@ import matplotlib.pyplot as plt
 
 GARNER_DIR = os.path.dirname(os.path.dirname(os.path.realpath(__file__)))
 
-PROTOCOLS = ("silo", "silo_hv", "silo_nr")
+PROTOCOLS = (
+    "silo",
+    "silo_hv",
+    "silo_ad",
+    "silo_nr",
+    "2pl_nowait",
+    "2pl_waitdie",
+    "tictoc",
+)
 
 
 def simple_bench_path(collect_latency):
@@ -27,11 +35,12 @@ def run_simple_benchmarks(
     num_warmup_ops,
     write_percentage,
     scan_range,
+    zipf_theta,
     collect_latency,
 ):
     print("Running benchmarks matrix...")
     print(
-        f" degree={degree}  #threads={num_threads}  #warmup={num_warmup_ops}  scan_range={'uniform' if scan_range == 0 else scan_range}  collect_latency={'yes' if collect_latency else 'no'}"
+        f" degree={degree}  #threads={num_threads}  #warmup={num_warmup_ops}  scan_range={'uniform' if scan_range == 0 else scan_range}  zipf_theta={zipf_theta}  collect_latency={'yes' if collect_latency else 'no'}"
     )
     for scan_percentage in sorted(scan_percentages):
         for protocol in PROTOCOLS:
@@ -52,8 +61,10 @@ def run_simple_benchmarks(
                     str(write_percentage),
                     "-s",
                     str(scan_range),
+                    "-z",
+                    str(zipf_theta),
                 ]
-                print(f" Running:  scan {scan_percentage:3d}%  {protocol:7s}")
+                print(f" Running:  scan {scan_percentage:3d}%  {protocol:11s}")
                 subprocess.run(
                     [simple_bench_path(collect_latency)] + options,
                     check=True,
@@ -120,7 +131,7 @@ def parse_results(scan_percentages, output_prefix, collect_latency):
 
                 if not collect_latency:
                     print(
-                        f" Result:  scan {scan_percentage:3d}%  {protocol:7s}"
+                        f" Result:  scan {scan_percentage:3d}%  {protocol:11s}"
                         f"  abort {avg_abort_rate:4.1f}%  {avg_throughput:10.2f} txns/sec"
                     )
                     results[protocol][scan_percentage] = {
@@ -132,7 +143,7 @@ def parse_results(scan_percentages, output_prefix, collect_latency):
                     avg_validate_time = sum(validate_times) / len(validate_times)
                     avg_commit_time = sum(commit_times) / len(commit_times)
                     print(
-                        f" Result:  scan {scan_percentage:3d}%  {protocol:7s}"
+                        f" Result:  scan {scan_percentage:3d}%  {protocol:11s}"
                         f"  abort {avg_abort_rate:4.1f}%  {avg_throughput:10.2f} txns/sec"
                         f"  exec {avg_exec_time:8.2f} μs"
                         f"  lock {avg_lock_time:8.4f} μs"
@@ -151,8 +162,24 @@ def parse_results(scan_percentages, output_prefix, collect_latency):
 
 
 def plot_results_throughput(scan_percentages, results, output_prefix):
-    protocol_marker = {"silo": "o", "silo_hv": "v", "silo_nr": "x"}
-    protocol_color = {"silo": "steelblue", "silo_hv": "orange", "silo_nr": "red"}
+    protocol_marker = {
+        "silo": "o",
+        "silo_hv": "v",
+        "silo_ad": "s",
+        "silo_nr": "x",
+        "2pl_nowait": "^",
+        "2pl_waitdie": "D",
+        "tictoc": "P",
+    }
+    protocol_color = {
+        "silo": "steelblue",
+        "silo_hv": "orange",
+        "silo_ad": "mediumseagreen",
+        "silo_nr": "red",
+        "2pl_nowait": "purple",
+        "2pl_waitdie": "gray",
+        "tictoc": "brown",
+    }
 
     plt.rcParams.update({"font.size": 18})
 
@@ -187,7 +214,7 @@ def plot_results_throughput(scan_percentages, results, output_prefix):
 def plot_results_latency(scan_percentages, results, output_prefix):
     for scan_percentage in scan_percentages:
         # labels = PROTOCOLS
-        labels = ("silo", "silo_hv")
+        labels = ("silo", "silo_hv", "silo_ad", "tictoc")
         exec_times = [
             results[protocol][scan_percentage]["exec_time"] for protocol in labels
         ]
@@ -243,6 +270,9 @@ if __name__ == "__main__":
         "-r", "--write_percentage", dest="write_percentage", type=int, default=10
     )
     parser.add_argument("-s", "--scan_range", dest="scan_range", type=int, default=0)
+    parser.add_argument(
+        "-z", "--zipf_theta", dest="zipf_theta", type=float, default=0.0
+    )
     parser.add_argument("-l", "--latency", dest="collect_latency", action="store_true")
     parser.add_argument(
         "scan_percentages",
@@ -269,6 +299,10 @@ if __name__ == "__main__":
         print(f"Error: invalid scan range {args.scan_range}")
         exit(1)
 
+    if args.zipf_theta < 0.0 or args.zipf_theta >= 1.0:
+        print(f"Error: invalid Zipfian skew {args.zipf_theta}")
+        exit(1)
+
     if args.write_percentage < 0:
         print(f"Error: invalid write percentage {args.write_percentage}")
         exit(1)
@@ -287,6 +321,7 @@ if __name__ == "__main__":
         args.num_warmup_ops,
         args.write_percentage,
         args.scan_range,
+        args.zipf_theta,
         args.collect_latency,
     )
     results = parse_results(
@@ -0,0 +1,203 @@
+#include <cassert>
+#include <iostream>
+#include <map>
+#include <random>
+#include <set>
+#include <stdexcept>
+#include <string>
+#include <tuple>
+#include <vector>
+
+#include "cxxopts.hpp"
+#include "garner.hpp"
+#include "utils.hpp"
+
+static constexpr size_t TEST_DEGREE = 6;
+
+// a small number of accounts to make batch transactions conflict a lot
+static constexpr size_t NUM_ACCOUNTS = 64;
+
+static unsigned NUM_ROUNDS = 1;
+static unsigned NUM_WORKERS = 4;
+static size_t NUM_TXNS = 20000;
+
+// order-sensitive combination of two values, so that any reordering of
+// conflicting transactions shows up in the final state
+static std::string combine(const std::string& a, const std::string& b) {
+    return std::to_string((std::stoul(a) * 31 + std::stoul(b) + 7) % 1000003);
+}
+
+/**
+ * Transaction kinds of the generated batch:
+ *   READ:    reads a and b, saving what it saw
+ *   COMBINE: reads a and b, writes dst with their combination
+ *   INSERT:  writes a fresh key dst with no reads
+ */
+enum BatchOp { READ, COMBINE, INSERT };
+
+struct BatchReq {
+    BatchOp op;
+    std::string a, b, dst;
+    std::string seen_a, seen_b;
+};
+
+static void batch_test_round(garner::TxnProtocol protocol) {
+    auto* gn = garner::Garner::Open(TEST_DEGREE, protocol);
+
+    std::cout << " Degree=" << TEST_DEGREE << " #workers=" << NUM_WORKERS
+              << " #txns=" << NUM_TXNS << std::endl;
+
+    std::cout << " Populating accounts..." << std::endl;
+    std::map<std::string, std::string> refmap =
+        populate_keys(gn, account_key, NUM_ACCOUNTS,
+                      [](size_t i) { return std::to_string(i); });
+
+    std::cout << " Generating batch..." << std::endl;
+    std::random_device rd;
+    std::mt19937 gen(rd());
+    std::uniform_int_distribution<size_t> rand_account(0, NUM_ACCOUNTS - 1);
+    std::uniform_int_distribution<unsigned> rand_op(0, 9);
+
+    // reqs must not move once bodies capture pointers into it
+    std::vector<BatchReq> reqs(NUM_TXNS);
+    std::vector<garner::Garner::BatchTxn> batch;
+    batch.reserve(NUM_TXNS);
+    for (size_t i = 0; i < NUM_TXNS; ++i) {
+        unsigned op_choice = rand_op(gen);
+        BatchReq* req = &reqs[i];
+        req->op = (op_choice < 3) ? READ : (op_choice < 9) ? COMBINE : INSERT;
+        req->a = account_key(rand_account(gen));
+        req->b = account_key(rand_account(gen));
+        req->dst = (req->op == INSERT) ? "new-" + gen_rand_string(gen, 8)
+                                       : account_key(rand_account(gen));
+
+        garner::Garner::BatchTxn txn;
+        if (req->op != INSERT) txn.read_keys = {req->a, req->b};
+        if (req->op != READ) txn.write_keys = {req->dst};
+        txn.body = [gn, req] {
+            if (req->op == INSERT) {
+                gn->Put(req->dst, "0");
+                return;
+            }
+            bool found_a, found_b;
+            gn->Get(req->a, req->seen_a, found_a);
+            gn->Get(req->b, req->seen_b, found_b);
+            if (!found_a || !found_b)
+                throw FuzzTestException("account not found in batch txn");
+            if (req->op == COMBINE)
+                gn->Put(req->dst, combine(req->seen_a, req->seen_b));
+        };
+        batch.push_back(std::move(txn));
+    }
+
+    std::cout << " Running batch..." << std::endl;
+    gn->RunBatch(batch, NUM_WORKERS);
+
+    std::cout << " Checking against serial execution..." << std::endl;
+    for (auto&& req : reqs) {
+        if (req.op == INSERT) {
+            refmap[req.dst] = "0";
+            continue;
+        }
+        if (req.seen_a != refmap[req.a] || req.seen_b != refmap[req.b]) {
+            throw FuzzTestException("batch read mismatch: " + req.a + "=" +
+                                    req.seen_a + " " + req.b + "=" +
+                                    req.seen_b + ", expected " +
+                                    refmap[req.a] + " " + refmap[req.b]);
+        }
+        if (req.op == COMBINE)
+            refmap[req.dst] = combine(req.seen_a, req.seen_b);
+    }
+
+    std::vector<std::tuple<std::string, std::string>> scan_result;
+    size_t nrecords;
+    gn->Scan("", "~", scan_result, nrecords);
+    if (nrecords != refmap.size()) {
+        throw FuzzTestException("final scan got " + std::to_string(nrecords) +
+                                " records, expected " +
+                                std::to_string(refmap.size()));
+    }
+    for (auto&& [key, val] : scan_result) {
+        if (refmap[key] != val) {
+            throw FuzzTestException("final value mismatch: key=" + key +
+                                    " val=" + val + " refval=" + refmap[key]);
+        }
+    }
+
+    std::cout << " Checking exception propagation..." << std::endl;
+    std::vector<garner::Garner::BatchTxn> bad_batch(2);
+    bad_batch[0].write_keys = {account_key(0)};
+    bad_batch[0].body = [] { throw std::runtime_error("expected"); };
+    bad_batch[1].write_keys = {account_key(0)};
+    bad_batch[1].body = [gn] { gn->Put(account_key(0), "42"); };
+    try {
+        gn->RunBatch(bad_batch, NUM_WORKERS);
+        throw FuzzTestException("exception in body not propagated");
+    } catch (const std::runtime_error&) {
+    }
+    std::string val;
+    bool found;
+    gn->Get(account_key(0), val, found);
+    if (!found || val != "42")
+        throw FuzzTestException("batch stopped at exception in body");
+
+    std::cout << " Deterministic batch tests passed!" << std::endl;
+    delete gn;
+}
+
+int main(int argc, char* argv[]) {
+    bool help;
+    std::string protocol_str;
+
+    cxxopts::Options cmd_args(argv[0]);
+    cmd_args.add_options()("h,help", "print help message",
+                           cxxopts::value<bool>(help)->default_value("false"))(
+        "r,rounds", "number of rounds",
+        cxxopts::value<unsigned>(NUM_ROUNDS)->default_value("1"))(
+        "p,protocol", "concurency control protocol",
+        cxxopts::value<std::string>(protocol_str)->default_value("silo"))(
+        "w,workers", "number of batch workers",
+        cxxopts::value<unsigned>(NUM_WORKERS)->default_value("4"))(
+        "o,txns", "number of txns per batch",
+        cxxopts::value<size_t>(NUM_TXNS)->default_value("20000"));
+    auto result = cmd_args.parse(argc, argv);
+
+    std::set<std::string> valid_protocols{"none", "silo", "silo_hv",
+                                          "tictoc"};
+
+    if (help) {
+        printf("%s", cmd_args.help().c_str());
+        std::cout << std::endl << "Valid concurrency control protocols:  ";
+        for (auto&& p : valid_protocols) std::cout << p << "  ";
+        std::cout << std::endl;
+        return 0;
+    }
+
+    garner::TxnProtocol protocol;
+    if (protocol_str == "none")
+        protocol = garner::PROTOCOL_NONE;
+    else if (protocol_str == "silo")
+        protocol = garner::PROTOCOL_SILO;
+    else if (protocol_str == "silo_hv")
+        protocol = garner::PROTOCOL_SILO_HV;
+    else if (protocol_str == "tictoc")
+        protocol = garner::PROTOCOL_TICTOC;
+    else {
+        std::cerr << "Error: unrecognized concurrency control protocol: "
+                  << protocol_str << std::endl;
+        return 1;
+    }
+
+    if (NUM_WORKERS == 0) {
+        std::cerr << "Error: number of batch workers must be positive"
+                  << std::endl;
+        return 1;
+    }
+
+    for (unsigned round = 0; round < NUM_ROUNDS; ++round) {
+        std::cout << "Round " << round << " --" << std::endl;
+        batch_test_round(protocol);
+    }
+
+    return 0;
+}
@@ -0,0 +1,297 @@
+#include <atomic>
+#include <cassert>
+#include <chrono>
+#include <iostream>
+#include <latch>
+#include <random>
+#include <set>
+#include <stdexcept>
+#include <string>
+#include <thread>
+#include <tuple>
+#include <vector>
+
+#include "cxxopts.hpp"
+#include "garner.hpp"
+#include "utils.hpp"
+
+static constexpr size_t TEST_DEGREE = 6;
+
+// a small number of accounts and counters to make transactions conflict a lot
+static constexpr size_t NUM_ACCOUNTS = 32;
+static constexpr size_t NUM_COUNTERS = 4;
+static constexpr long INIT_BALANCE = 1000;
+
+// long enough for the global epoch to move a few times, so that a snapshot
+// picked afterwards covers everything committed before
+static constexpr auto EPOCH_SETTLE_TIME = std::chrono::milliseconds(200);
+
+static unsigned NUM_ROUNDS = 1;
+static unsigned NUM_THREADS = 4;
+static size_t NUM_TXNS_PER_THREAD = 4000;
+
+static std::string increment(const std::string& value, bool found) {
+    if (!found) throw FuzzTestException("counter not found in increment");
+    return std::to_string(std::stol(value) + 1);
+}
+
+/**
+ * Transaction kinds run by each thread:
+ *   TRANSFER: serializable, moves an amount between two accounts
+ *   AUDIT:    snapshot isolation, sums all accounts and inserts a fresh key
+ *   COUNT:    read committed, increments two counters through Updates
+ */
+static void client_thread_func(garner::Garner* gn,
+                               std::vector<std::atomic<size_t>>* expected,
+                               std::vector<std::string>* audit_keys,
+                               std::latch* init_barrier) {
+    std::random_device rd;
+    std::mt19937 gen(rd());
+    std::uniform_int_distribution<size_t> rand_account(0, NUM_ACCOUNTS - 1);
+    std::uniform_int_distribution<size_t> rand_counter(0, NUM_COUNTERS - 1);
+    std::uniform_int_distribution<long> rand_amount(0, 10);
+    std::uniform_int_distribution<unsigned> rand_kind(0, 2);
+
+    garner::RetryPolicy policy;
+    policy.max_retries = 0;
+
+    init_barrier->count_down();
+    init_barrier->wait();
+
+    for (size_t i = 0; i < NUM_TXNS_PER_THREAD; ++i) {
+        unsigned kind = rand_kind(gen);
+
+        if (kind == 0) {
+            size_t from = rand_account(gen), to = rand_account(gen);
+            long amount = rand_amount(gen);
+            gn->RunTxn(
+                [&](garner::TxnCxt<std::string, std::string>* txn) {
+                    std::string from_val, to_val;
+                    bool found;
+                    gn->Get(account_key(from), from_val, found, txn);
+                    if (gn->TxnDoomed(txn)) return;
+                    gn->Get(account_key(to), to_val, found, txn);
+                    if (gn->TxnDoomed(txn)) return;
+                    long from_bal = std::stol(from_val);
+                    long to_bal = std::stol(to_val);
+                    if (from == to) return;
+                    gn->Put(account_key(from),
+                            std::to_string(from_bal - amount), txn);
+                    gn->Put(account_key(to), std::to_string(to_bal + amount),
+                            txn);
+                },
+                policy);
+
+        } else if (kind == 1) {
+            auto* txn = gn->StartTxn(garner::TXN_READ_WRITE,
+                                     garner::ISOLATION_SNAPSHOT);
+            std::vector<std::tuple<std::string, std::string>> results;
+            size_t nrecords;
+            gn->Scan(account_key(0), account_key(NUM_ACCOUNTS - 1), results,
+                     nrecords, txn);
+            std::string first_val;
+            bool found;
+            gn->Get(account_key(0), first_val, found, txn);
+            std::string audit_key = "audit-" + gen_rand_string(gen, 8);
+            gn->Put(audit_key, "0", txn);
+
+            // a version pruned from under the snapshot aborts it, in which
+            // case nothing read is guaranteed
+            bool committed = gn->FinishTxn(txn);
+            if (!committed) continue;
+            audit_keys->push_back(audit_key);
+
+            if (nrecords != NUM_ACCOUNTS)
+                throw FuzzTestException("snapshot scan missed accounts");
+            long sum = 0;
+            for (auto&& [_, val] : results) sum += std::stol(val);
+            if (sum != INIT_BALANCE * static_cast<long>(NUM_ACCOUNTS)) {
+                throw FuzzTestException("snapshot saw inconsistent sum " +
+                                        std::to_string(sum));
+            }
+            if (!found || first_val != std::get<1>(results[0])) {
+                throw FuzzTestException("snapshot read not repeatable: " +
+                                        first_val + " after " +
+                                        std::get<1>(results[0]));
+            }
+
+        } else {
+            size_t ca = rand_counter(gen), cb = rand_counter(gen);
+            auto* txn = gn->StartTxn(garner::TXN_READ_WRITE,
+                                     garner::ISOLATION_READ_COMMITTED);
+            gn->Update(counter_key(ca), increment, txn);
+            gn->Update(counter_key(cb), increment, txn);
+            if (!gn->FinishTxn(txn))
+                throw FuzzTestException("read committed increment aborted");
+            (*expected)[ca]++;
+            (*expected)[cb]++;
+        }
+    }
+}
+
+/**
+ * Single-threaded checks of what each level does and does not guarantee.
+ */
+static void check_isolation_semantics(garner::Garner* gn) {
+    gn->Put("iso-x", "0");
+    gn->Put("iso-y", "0");
+    std::this_thread::sleep_for(EPOCH_SETTLE_TIME);
+
+    std::string val;
+    bool found;
+
+    // snapshot isolation: repeatable reads, first committer wins
+    auto* txn_a =
+        gn->StartTxn(garner::TXN_READ_WRITE, garner::ISOLATION_SNAPSHOT);
+    auto* txn_b =
+        gn->StartTxn(garner::TXN_READ_WRITE, garner::ISOLATION_SNAPSHOT);
+    gn->Get("iso-x", val, found, txn_a);
+    gn->Get("iso-x", val, found, txn_b);
+    gn->Put("iso-y", "1");
+    gn->Get("iso-y", val, found, txn_a);
+    if (!found || val != "0")
+        throw FuzzTestException("snapshot saw a later commit: " + val);
+    gn->Put("iso-x", "a", txn_a);
+    gn->Put("iso-x", "b", txn_b);
+    if (!gn->FinishTxn(txn_a))
+        throw FuzzTestException("first snapshot committer aborted");
+    if (gn->FinishTxn(txn_b))
+        throw FuzzTestException("second snapshot committer not aborted");
+    gn->Get("iso-x", val, found);
+    if (!found || val != "a")
+        throw FuzzTestException("first snapshot committer lost: " + val);
+
+    // a record written since the snapshot but before a blind write to it is
+    // no conflict; reading it from the snapshot and then writing it is, as
+    // that would lose the newer version
+    gn->Put("iso-x", "d");
+    auto* txn_d =
+        gn->StartTxn(garner::TXN_READ_WRITE, garner::ISOLATION_SNAPSHOT);
+    gn->Get("iso-y", val, found, txn_d);
+    gn->Put("iso-x", "e", txn_d);
+    if (!gn->FinishTxn(txn_d))
+        throw FuzzTestException("snapshot blind write to a recent record "
+                                "aborted");
+    gn->Put("iso-x", "f");
+    auto* txn_e =
+        gn->StartTxn(garner::TXN_READ_WRITE, garner::ISOLATION_SNAPSHOT);
+    gn->Get("iso-x", val, found, txn_e);
+    bool saw_latest = found && val == "f";
+    gn->Put("iso-x", "g", txn_e);
+    if (gn->FinishTxn(txn_e) != saw_latest)
+        throw FuzzTestException("snapshot write conflict misjudged: read " +
+                                val);
+
+    // read committed: reads see the latest commit, Updates lose nothing
+    auto* txn_c =
+        gn->StartTxn(garner::TXN_READ_WRITE, garner::ISOLATION_READ_COMMITTED);
+    gn->Get("iso-y", val, found, txn_c);
+    gn->Update("iso-y", increment, txn_c);
+    gn->Put("iso-y", "10");
+    gn->Get("iso-x", val, found, txn_c);
+    gn->Put("iso-x", "c");
+    gn->Get("iso-x", val, found, txn_c);
+    if (!found || val != "c")
+        throw FuzzTestException("read committed missed a commit: " + val);
+    if (!gn->FinishTxn(txn_c))
+        throw FuzzTestException("read committed transaction aborted");
+    gn->Get("iso-y", val, found);
+    if (!found || val != "11")
+        throw FuzzTestException("read committed Update lost a write: " + val);
+}
+
+static void isolation_test_round(garner::TxnProtocol protocol) {
+    auto* gn = garner::Garner::Open(TEST_DEGREE, protocol);
+
+    std::cout << " Degree=" << TEST_DEGREE << " #threads=" << NUM_THREADS
+              << " #txns/thread=" << NUM_TXNS_PER_THREAD << std::endl;
+
+    std::cout << " Populating accounts and counters..." << std::endl;
+    populate_keys(gn, account_key, NUM_ACCOUNTS,
+                  [](size_t) { return std::to_string(INIT_BALANCE); });
+    populate_keys(gn, counter_key, NUM_COUNTERS, [](size_t) { return "0"; });
+    std::this_thread::sleep_for(EPOCH_SETTLE_TIME);
+
+    std::cout << " Running mixed isolation levels..." << std::endl;
+    std::vector<std::atomic<size_t>> expected(NUM_COUNTERS);
+    std::vector<std::vector<std::string>> audit_keys(NUM_THREADS);
+    std::vector<std::thread> threads;
+    std::latch init_barrier(NUM_THREADS);
+    for (unsigned tidx = 0; tidx < NUM_THREADS; ++tidx) {
+        threads.push_back(std::thread(client_thread_func, gn, &expected,
+                                      &audit_keys[tidx], &init_barrier));
+    }
+    for (auto&& thread : threads) thread.join();
+
+    std::cout << " Checking final state..." << std::endl;
+    std::vector<std::tuple<std::string, std::string>> results;
+    size_t nrecords;
+    gn->Scan(account_key(0), account_key(NUM_ACCOUNTS - 1), results, nrecords);
+    long sum = 0;
+    for (auto&& [_, val] : results) sum += std::stol(val);
+    if (sum != INIT_BALANCE * static_cast<long>(NUM_ACCOUNTS))
+        throw FuzzTestException("final sum is " + std::to_string(sum));
+    check_counters(gn, expected);
+    for (auto&& keys : audit_keys) {
+        for (auto&& key : keys) {
+            std::string val;
+            bool found;
+            gn->Get(key, val, found);
+            if (!found) throw FuzzTestException("audit key lost: " + key);
+        }
+    }
+
+    std::cout << " Checking isolation semantics..." << std::endl;
+    check_isolation_semantics(gn);
+
+    std::cout << " Concurrent isolation tests passed!" << std::endl;
+    delete gn;
+}
+
+int main(int argc, char* argv[]) {
+    bool help;
+    std::string protocol_str;
+
+    cxxopts::Options cmd_args(argv[0]);
+    cmd_args.add_options()("h,help", "print help message",
+                           cxxopts::value<bool>(help)->default_value("false"))(
+        "r,rounds", "number of rounds",
+        cxxopts::value<unsigned>(NUM_ROUNDS)->default_value("1"))(
+        "p,protocol", "concurency control protocol",
+        cxxopts::value<std::string>(protocol_str)->default_value("silo"))(
+        "t,threads", "number of client threads",
+        cxxopts::value<unsigned>(NUM_THREADS)->default_value("4"))(
+        "o,txns", "number of txns per thread per round",
+        cxxopts::value<size_t>(NUM_TXNS_PER_THREAD)->default_value("4000"));
+    auto result = cmd_args.parse(argc, argv);
+
+    std::set<std::string> valid_protocols{"silo", "silo_hv", "silo_ad"};
+
+    if (help) {
+        printf("%s", cmd_args.help().c_str());
+        std::cout << std::endl << "Valid concurrency control protocols:  ";
+        for (auto&& p : valid_protocols) std::cout << p << "  ";
+        std::cout << std::endl;
+        return 0;
+    }
+
+    garner::TxnProtocol protocol;
+    if (protocol_str == "silo")
+        protocol = garner::PROTOCOL_SILO;
+    else if (protocol_str == "silo_hv")
+        protocol = garner::PROTOCOL_SILO_HV;
+    else if (protocol_str == "silo_ad")
+        protocol = garner::PROTOCOL_SILO_AD;
+    else {
+        std::cerr << "Error: unrecognized concurrency control protocol: "
+                  << protocol_str << std::endl;
+        return 1;
+    }
+
+    for (unsigned round = 0; round < NUM_ROUNDS; ++round) {
+        std::cout << "Round " << round << " --" << std::endl;
+        isolation_test_round(protocol);
+    }
+
+    return 0;
+}
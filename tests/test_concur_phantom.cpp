@@ -0,0 +1,219 @@
+#include <cassert>
+#include <iostream>
+#include <latch>
+#include <random>
+#include <set>
+#include <stdexcept>
+#include <string>
+#include <thread>
+#include <tuple>
+#include <vector>
+
+#include "cxxopts.hpp"
+#include "garner.hpp"
+#include "utils.hpp"
+
+static constexpr size_t TEST_DEGREE = 6;
+
+// keys are "k" followed by this many random characters; scans cover all keys
+// sharing one less character, so that they run into others' phantoms
+static constexpr size_t KEY_RAND_LEN = 3;
+static constexpr size_t NUM_PUTS_PER_TXN = 3;
+static constexpr size_t NUM_PHANTOM_RUN_KEYS = 200;
+
+static unsigned NUM_ROUNDS = 1;
+static unsigned NUM_THREADS = 4;
+static size_t NUM_TXNS_PER_THREAD = 3000;
+
+/** Thrown by a transaction body to abort it on purpose. */
+class ExplicitAbort : public std::exception {};
+
+/**
+ * Each transaction scans a small key range, gets a key and inserts a few
+ * fresh keys, then either aborts on purpose or tries to commit, which may
+ * fail on conflicts as well.
+ */
+static void client_thread_func(garner::Garner* gn,
+                               std::vector<std::string>* committed_keys,
+                               std::latch* init_barrier) {
+    std::random_device rd;
+    std::mt19937 gen(rd());
+    std::uniform_int_distribution<unsigned> rand_abort(0, 1);
+
+    garner::RetryPolicy policy;
+    policy.max_retries = 1;
+
+    init_barrier->count_down();
+    init_barrier->wait();
+
+    std::vector<std::string> keys;
+    for (size_t i = 0; i < NUM_TXNS_PER_THREAD; ++i) {
+        bool explicit_abort = rand_abort(gen) == 0;
+        try {
+            bool committed = gn->RunTxn(
+                [&](garner::TxnCxt<std::string, std::string>* txn) {
+                    keys.clear();
+                    std::string prefix =
+                        "k" + gen_rand_string(gen, KEY_RAND_LEN - 1);
+                    std::vector<std::tuple<std::string, std::string>> results;
+                    size_t nrecords;
+                    gn->Scan(prefix, prefix + "~", results, nrecords, txn);
+                    std::string val;
+                    bool found;
+                    gn->Get("k" + gen_rand_string(gen, KEY_RAND_LEN), val,
+                            found, txn);
+                    for (size_t j = 0; j < NUM_PUTS_PER_TXN; ++j) {
+                        keys.push_back("k" +
+                                       gen_rand_string(gen, KEY_RAND_LEN));
+                        gn->Put(keys.back(), "v", txn);
+                    }
+                    if (explicit_abort) throw ExplicitAbort();
+                },
+                policy);
+            if (committed)
+                committed_keys->insert(committed_keys->end(), keys.begin(),
+                                       keys.end());
+        } catch (const ExplicitAbort&) {
+        }
+    }
+}
+
+/**
+ * Insert a run of fresh keys in a transaction that aborts, after which only
+ * leaves made up of its phantoms alone may keep one of them.
+ */
+static void check_aborted_run(garner::Garner* gn) {
+    garner::BPTreeStats before = gn->GatherStats();
+    try {
+        gn->RunTxn([&](garner::TxnCxt<std::string, std::string>* txn) {
+            for (size_t i = 0; i < NUM_PHANTOM_RUN_KEYS; ++i) {
+                std::string num = std::to_string(i);
+                gn->Put("phantom-" + std::string(4 - num.size(), '0') + num,
+                        "v", txn);
+            }
+            throw ExplicitAbort();
+        });
+    } catch (const ExplicitAbort&) {
+    }
+    garner::BPTreeStats after = gn->GatherStats();
+
+    std::cout << " Aborted run of " << NUM_PHANTOM_RUN_KEYS << " inserts left "
+              << after.nkeys_leaf - before.nkeys_leaf << " keys in "
+              << after.npages_leaf - before.npages_leaf << " new leaves"
+              << std::endl;
+    if (after.nkeys_leaf - before.nkeys_leaf >
+        after.npages_leaf - before.npages_leaf) {
+        throw FuzzTestException("aborted run left " +
+                                std::to_string(after.nkeys_leaf -
+                                               before.nkeys_leaf) +
+                                " phantoms behind");
+    }
+
+    std::string val;
+    bool found;
+    gn->Get("phantom-0000", val, found);
+    if (found) throw FuzzTestException("aborted insert found");
+}
+
+static void phantom_test_round(garner::TxnProtocol protocol) {
+    auto* gn = garner::Garner::Open(TEST_DEGREE, protocol);
+
+    std::cout << " Degree=" << TEST_DEGREE << " #threads=" << NUM_THREADS
+              << " #txns/thread=" << NUM_TXNS_PER_THREAD << std::endl;
+
+    std::cout << " Running aborting inserts..." << std::endl;
+    std::vector<std::vector<std::string>> committed_keys(NUM_THREADS);
+    std::vector<std::thread> threads;
+    std::latch init_barrier(NUM_THREADS);
+    for (unsigned tidx = 0; tidx < NUM_THREADS; ++tidx) {
+        threads.push_back(std::thread(client_thread_func, gn,
+                                      &committed_keys[tidx], &init_barrier));
+    }
+    for (auto&& thread : threads) thread.join();
+
+    std::cout << " Checking committed keys..." << std::endl;
+    std::set<std::string> expected;
+    for (auto&& keys : committed_keys)
+        expected.insert(keys.begin(), keys.end());
+    std::vector<std::tuple<std::string, std::string>> results;
+    size_t nrecords;
+    gn->Scan("", "~", results, nrecords);
+    if (nrecords != expected.size()) {
+        throw FuzzTestException("final scan got " + std::to_string(nrecords) +
+                                " records, expected " +
+                                std::to_string(expected.size()));
+    }
+    for (auto&& [key, _] : results) {
+        if (!expected.contains(key))
+            throw FuzzTestException("uncommitted key visible: " + key);
+    }
+
+    // a leaf that is not the root keeps its last key even if a phantom, and
+    // never holds two such keys, since leaves never merge
+    garner::BPTreeStats stats = gn->GatherStats();
+    std::cout << " " << stats.nkeys_leaf - nrecords << " phantoms left among "
+              << nrecords << " records in " << stats.npages_leaf << " leaves"
+              << std::endl;
+    if (stats.nkeys_leaf - nrecords > stats.npages_leaf) {
+        throw FuzzTestException("phantoms not collected: " +
+                                std::to_string(stats.nkeys_leaf - nrecords) +
+                                " left");
+    }
+
+    std::cout << " Checking aborted run of inserts..." << std::endl;
+    check_aborted_run(gn);
+
+    std::cout << " Phantom collection tests passed!" << std::endl;
+    delete gn;
+}
+
+int main(int argc, char* argv[]) {
+    bool help;
+    std::string protocol_str;
+
+    cxxopts::Options cmd_args(argv[0]);
+    cmd_args.add_options()("h,help", "print help message",
+                           cxxopts::value<bool>(help)->default_value("false"))(
+        "r,rounds", "number of rounds",
+        cxxopts::value<unsigned>(NUM_ROUNDS)->default_value("1"))(
+        "p,protocol", "concurency control protocol",
+        cxxopts::value<std::string>(protocol_str)->default_value("silo"))(
+        "t,threads", "number of client threads",
+        cxxopts::value<unsigned>(NUM_THREADS)->default_value("4"))(
+        "o,txns", "number of txns per thread per round",
+        cxxopts::value<size_t>(NUM_TXNS_PER_THREAD)->default_value("3000"));
+    auto result = cmd_args.parse(argc, argv);
+
+    std::set<std::string> valid_protocols{"silo", "silo_hv", "2pl_nowait",
+                                          "tictoc"};
+
+    if (help) {
+        printf("%s", cmd_args.help().c_str());
+        std::cout << std::endl << "Valid concurrency control protocols:  ";
+        for (auto&& p : valid_protocols) std::cout << p << "  ";
+        std::cout << std::endl;
+        return 0;
+    }
+
+    garner::TxnProtocol protocol;
+    if (protocol_str == "silo")
+        protocol = garner::PROTOCOL_SILO;
+    else if (protocol_str == "silo_hv")
+        protocol = garner::PROTOCOL_SILO_HV;
+    else if (protocol_str == "2pl_nowait")
+        protocol = garner::PROTOCOL_2PL_NOWAIT;
+    else if (protocol_str == "tictoc")
+        protocol = garner::PROTOCOL_TICTOC;
+    else {
+        std::cerr << "Error: unrecognized concurrency control protocol: "
+                  << protocol_str << std::endl;
+        return 1;
+    }
+
+    for (unsigned round = 0; round < NUM_ROUNDS; ++round) {
+        std::cout << "Round " << round << " --" << std::endl;
+        phantom_test_round(protocol);
+    }
+
+    return 0;
+}
@@ -0,0 +1,183 @@
+#include <atomic>
+#include <cassert>
+#include <future>
+#include <iostream>
+#include <latch>
+#include <random>
+#include <set>
+#include <stdexcept>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include "cxxopts.hpp"
+#include "garner.hpp"
+#include "utils.hpp"
+
+static constexpr size_t TEST_DEGREE = 6;
+
+// a small number of counters to make submitted transactions conflict a lot
+static constexpr size_t NUM_COUNTERS = 16;
+
+static unsigned NUM_ROUNDS = 1;
+static unsigned NUM_PRODUCERS = 4;
+static unsigned NUM_WORKERS = 4;
+static size_t NUM_TXNS_PER_THREAD = 4000;
+
+static void increment(garner::Garner* gn,
+                      garner::TxnCxt<std::string, std::string>* txn,
+                      size_t idx) {
+    std::string val;
+    bool found;
+    gn->Get(counter_key(idx), val, found, txn);
+    if (gn->TxnDoomed(txn)) return;
+    if (!found) throw FuzzTestException("counter not found in increment");
+    gn->Put(counter_key(idx), std::to_string(std::stol(val) + 1), txn);
+}
+
+static void producer_thread_func(
+    garner::Garner* gn, std::vector<std::atomic<size_t>>* expected,
+    std::latch* init_barrier) {
+    std::random_device rd;
+    std::mt19937 gen(rd());
+    std::uniform_int_distribution<size_t> rand_counter(0, NUM_COUNTERS - 1);
+    std::uniform_int_distribution<unsigned> rand_undeclared(0, 9);
+
+    // retry until committed, so that all increments must show up
+    garner::RetryPolicy policy;
+    policy.max_retries = 0;
+
+    init_barrier->count_down();
+    init_barrier->wait();
+
+    std::vector<std::future<bool>> futures;
+    futures.reserve(NUM_TXNS_PER_THREAD);
+    for (size_t i = 0; i < NUM_TXNS_PER_THREAD; ++i) {
+        // occasionally insert a fresh key, which conflicts with nothing
+        if (rand_undeclared(gen) == 0) {
+            std::string key = "new-" + gen_rand_string(gen, 8);
+            futures.push_back(gn->SubmitTxn(
+                [gn, key](garner::TxnCxt<std::string, std::string>* txn) {
+                    gn->Put(key, "0", txn);
+                },
+                {key}, policy));
+            continue;
+        }
+
+        size_t ca = rand_counter(gen), cb = rand_counter(gen);
+        (*expected)[ca]++;
+        (*expected)[cb]++;
+
+        // occasionally declare only part of the key set, which routing must
+        // tolerate
+        std::vector<std::string> keys{counter_key(ca)};
+        if (rand_undeclared(gen) != 0) keys.push_back(counter_key(cb));
+
+        futures.push_back(gn->SubmitTxn(
+            [gn, ca, cb](garner::TxnCxt<std::string, std::string>* txn) {
+                increment(gn, txn, ca);
+                increment(gn, txn, cb);
+            },
+            keys, policy));
+    }
+
+    for (auto&& future : futures) {
+        if (!future.get())
+            throw FuzzTestException("submitted transaction not committed");
+    }
+}
+
+static void sched_test_round(garner::TxnProtocol protocol) {
+    auto* gn = garner::Garner::Open(TEST_DEGREE, protocol, 0, NUM_WORKERS);
+
+    std::cout << " Degree=" << TEST_DEGREE << " #producers=" << NUM_PRODUCERS
+              << " #workers=" << NUM_WORKERS
+              << " #txns/thread=" << NUM_TXNS_PER_THREAD << std::endl;
+
+    std::cout << " Populating counters..." << std::endl;
+    populate_keys(gn, counter_key, NUM_COUNTERS, [](size_t) { return "0"; });
+
+    std::cout << " Submitting increments..." << std::endl;
+    std::vector<std::atomic<size_t>> expected(NUM_COUNTERS);
+    std::vector<std::thread> threads;
+    std::latch init_barrier(NUM_PRODUCERS);
+    for (unsigned pidx = 0; pidx < NUM_PRODUCERS; ++pidx) {
+        threads.push_back(std::thread(producer_thread_func, gn, &expected,
+                                      &init_barrier));
+    }
+    for (auto&& thread : threads) thread.join();
+
+    std::cout << " Checking exception propagation..." << std::endl;
+    auto future = gn->SubmitTxn(
+        [](garner::TxnCxt<std::string, std::string>*) {
+            throw std::runtime_error("expected");
+        },
+        {counter_key(0)});
+    try {
+        future.get();
+        throw FuzzTestException("exception in body not propagated");
+    } catch (const std::runtime_error&) {
+    }
+
+    std::cout << " Checking counters..." << std::endl;
+    check_counters(gn, expected);
+
+    std::cout << " Concurrent scheduler tests passed!" << std::endl;
+    delete gn;
+}
+
+int main(int argc, char* argv[]) {
+    bool help;
+    std::string protocol_str;
+
+    cxxopts::Options cmd_args(argv[0]);
+    cmd_args.add_options()("h,help", "print help message",
+                           cxxopts::value<bool>(help)->default_value("false"))(
+        "r,rounds", "number of rounds",
+        cxxopts::value<unsigned>(NUM_ROUNDS)->default_value("1"))(
+        "p,protocol", "concurency control protocol",
+        cxxopts::value<std::string>(protocol_str)->default_value("silo"))(
+        "t,producers", "number of producer threads",
+        cxxopts::value<unsigned>(NUM_PRODUCERS)->default_value("4"))(
+        "w,workers", "number of scheduler workers",
+        cxxopts::value<unsigned>(NUM_WORKERS)->default_value("4"))(
+        "o,txns", "number of submitted txns per thread per round",
+        cxxopts::value<size_t>(NUM_TXNS_PER_THREAD)->default_value("4000"));
+    auto result = cmd_args.parse(argc, argv);
+
+    std::set<std::string> valid_protocols{"silo", "silo_hv", "tictoc"};
+
+    if (help) {
+        printf("%s", cmd_args.help().c_str());
+        std::cout << std::endl << "Valid concurrency control protocols:  ";
+        for (auto&& p : valid_protocols) std::cout << p << "  ";
+        std::cout << std::endl;
+        return 0;
+    }
+
+    garner::TxnProtocol protocol;
+    if (protocol_str == "silo")
+        protocol = garner::PROTOCOL_SILO;
+    else if (protocol_str == "silo_hv")
+        protocol = garner::PROTOCOL_SILO_HV;
+    else if (protocol_str == "tictoc")
+        protocol = garner::PROTOCOL_TICTOC;
+    else {
+        std::cerr << "Error: unrecognized concurrency control protocol: "
+                  << protocol_str << std::endl;
+        return 1;
+    }
+
+    if (NUM_WORKERS == 0) {
+        std::cerr << "Error: number of scheduler workers must be positive"
+                  << std::endl;
+        return 1;
+    }
+
+    for (unsigned round = 0; round < NUM_ROUNDS; ++round) {
+        std::cout << "Round " << round << " --" << std::endl;
+        sched_test_round(protocol);
+    }
+
+    return 0;
+}
@@ -0,0 +1,230 @@
+#include <atomic>
+#include <cassert>
+#include <chrono>
+#include <cstdio>
+#include <iomanip>
+#include <iostream>
+#include <latch>
+#include <random>
+#include <set>
+#include <stdexcept>
+#include <string>
+#include <thread>
+#include <tuple>
+#include <vector>
+
+#include "cxxopts.hpp"
+#include "garner.hpp"
+#include "utils.hpp"
+
+static constexpr size_t TEST_DEGREE = 6;
+
+// a small number of accounts to force many versions per record
+static constexpr size_t NUM_ACCOUNTS = 200;
+static constexpr long INIT_BALANCE = 1000;
+
+static unsigned NUM_ROUNDS = 1;
+static unsigned NUM_WRITERS = 6;
+static unsigned NUM_READERS = 2;
+static size_t NUM_TXNS_PER_THREAD = 4000;
+
+struct ReaderStats {
+    size_t num_txns = 0;
+    size_t num_committed = 0;
+};
+
+static long scan_total(garner::Garner* gn,
+                       garner::TxnCxt<std::string, std::string>* txn,
+                       size_t& nrecords) {
+    std::vector<std::tuple<std::string, std::string>> scan_result;
+    gn->Scan("", "~", scan_result, nrecords, txn);
+    long total = 0;
+    for (auto&& [key, val] : scan_result) total += std::stol(val);
+    return total;
+}
+
+static void writer_thread_func(unsigned tidx, garner::Garner* gn,
+                               std::latch* init_barrier) {
+    std::random_device rd;
+    std::mt19937 gen(rd());
+    std::uniform_int_distribution<size_t> rand_account(0, NUM_ACCOUNTS - 1);
+    std::uniform_int_distribution<long> rand_amount(1, 10);
+    std::uniform_int_distribution<unsigned> rand_insert(0, 9);
+
+    init_barrier->count_down();
+    init_barrier->wait();
+
+    for (size_t i = 0; i < NUM_TXNS_PER_THREAD; ++i) {
+        // occasionally insert a new zero-balance account, which keeps the
+        // total unchanged but splits leaves under concurrent scans
+        if (rand_insert(gen) == 0) {
+            std::string key = "new-" + std::to_string(tidx) + "-" +
+                              gen_rand_string(gen, 8);
+            gn->Put(key, "0");
+            continue;
+        }
+
+        size_t from = rand_account(gen), to = rand_account(gen);
+        long amount = rand_amount(gen);
+        gn->RunTxn([&](garner::TxnCxt<std::string, std::string>* txn) {
+            std::string from_val, to_val;
+            bool from_found, to_found;
+            gn->Get(account_key(from), from_val, from_found, txn);
+            gn->Get(account_key(to), to_val, to_found, txn);
+            if (gn->TxnDoomed(txn)) return;
+            if (!from_found || !to_found)
+                throw FuzzTestException("account not found in transfer");
+
+            long from_balance = std::stol(from_val) - amount;
+            long to_balance = std::stol(to_val) + amount;
+            if (from == to) to_balance = from_balance + amount;
+            gn->Put(account_key(from), std::to_string(from_balance), txn);
+            gn->Put(account_key(to), std::to_string(to_balance), txn);
+        });
+    }
+}
+
+static void reader_thread_func(garner::Garner* gn, garner::TxnMode mode,
+                               ReaderStats* stats, std::latch* init_barrier) {
+    init_barrier->count_down();
+    init_barrier->wait();
+
+    const long expected = NUM_ACCOUNTS * INIT_BALANCE;
+    for (size_t i = 0; i < NUM_TXNS_PER_THREAD / 10; ++i) {
+        auto* txn = gn->StartTxn(mode);
+        size_t nrecords;
+        long total = scan_total(gn, txn, nrecords);
+        bool committed = gn->FinishTxn(txn);
+
+        stats->num_txns++;
+        if (!committed) continue;
+        stats->num_committed++;
+
+        if (nrecords < NUM_ACCOUNTS) {
+            throw FuzzTestException(
+                "committed scan missed accounts: nrecords=" +
+                std::to_string(nrecords));
+        }
+        if (total != expected) {
+            throw FuzzTestException("committed scan saw inconsistent total " +
+                                    std::to_string(total) + ", expected " +
+                                    std::to_string(expected));
+        }
+    }
+}
+
+static void snapshot_test_round(garner::TxnProtocol protocol) {
+    auto* gn = garner::Garner::Open(TEST_DEGREE, protocol);
+
+    std::cout << " Degree=" << TEST_DEGREE << " #writers=" << NUM_WRITERS
+              << " #readers=" << NUM_READERS
+              << " #txns/thread=" << NUM_TXNS_PER_THREAD << std::endl;
+
+    std::cout << " Populating accounts..." << std::endl;
+    populate_keys(gn, account_key, NUM_ACCOUNTS,
+                  [](size_t) { return std::to_string(INIT_BALANCE); });
+
+    // a snapshot lags behind by a couple of epochs; wait until it covers
+    // all the accounts
+    std::cout << " Waiting for snapshot to catch up..." << std::endl;
+    while (true) {
+        auto* txn = gn->StartTxn(garner::TXN_SNAPSHOT);
+        size_t nrecords;
+        scan_total(gn, txn, nrecords);
+        gn->FinishTxn(txn);
+        if (nrecords == NUM_ACCOUNTS) break;
+        std::this_thread::sleep_for(std::chrono::milliseconds(10));
+    }
+
+    std::cout << " Running transfers against snapshot and read-only scans..."
+              << std::endl;
+    std::vector<std::thread> threads;
+    std::vector<ReaderStats> reader_stats(2 * NUM_READERS);
+    std::latch init_barrier(NUM_WRITERS + 2 * NUM_READERS);
+
+    for (unsigned tidx = 0; tidx < NUM_WRITERS; ++tidx) {
+        threads.push_back(
+            std::thread(writer_thread_func, tidx, gn, &init_barrier));
+    }
+    for (unsigned ridx = 0; ridx < 2 * NUM_READERS; ++ridx) {
+        garner::TxnMode mode =
+            (ridx % 2 == 0) ? garner::TXN_SNAPSHOT : garner::TXN_READ_ONLY;
+        threads.push_back(std::thread(reader_thread_func, gn, mode,
+                                      &reader_stats[ridx], &init_barrier));
+    }
+    for (auto&& thread : threads) thread.join();
+
+    for (unsigned mode_idx = 0; mode_idx < 2; ++mode_idx) {
+        size_t ntxns = 0, ncommitted = 0;
+        for (unsigned ridx = mode_idx; ridx < 2 * NUM_READERS; ridx += 2) {
+            ntxns += reader_stats[ridx].num_txns;
+            ncommitted += reader_stats[ridx].num_committed;
+        }
+        double abort_rate = static_cast<double>(ntxns - ncommitted) /
+                            static_cast<double>(ntxns);
+        std::cout << "  " << (mode_idx == 0 ? "Snapshot" : "Read-only")
+                  << " scan abort rate: " << ntxns - ncommitted << " / "
+                  << ntxns << " (" << std::fixed << std::setw(4)
+                  << std::setprecision(1) << abort_rate * 100 << "%)"
+                  << std::endl;
+    }
+
+    std::cout << " Concurrent snapshot tests passed!" << std::endl;
+    delete gn;
+}
+
+int main(int argc, char* argv[]) {
+    bool help;
+    std::string protocol_str;
+
+    cxxopts::Options cmd_args(argv[0]);
+    cmd_args.add_options()("h,help", "print help message",
+                           cxxopts::value<bool>(help)->default_value("false"))(
+        "r,rounds", "number of rounds",
+        cxxopts::value<unsigned>(NUM_ROUNDS)->default_value("1"))(
+        "p,protocol", "concurency control protocol",
+        cxxopts::value<std::string>(protocol_str)->default_value("silo"))(
+        "w,writers", "number of writer threads",
+        cxxopts::value<unsigned>(NUM_WRITERS)->default_value("6"))(
+        "s,readers", "number of reader threads per read mode",
+        cxxopts::value<unsigned>(NUM_READERS)->default_value("2"))(
+        "o,txns", "number of writer txns per thread per round",
+        cxxopts::value<size_t>(NUM_TXNS_PER_THREAD)->default_value("4000"));
+    auto result = cmd_args.parse(argc, argv);
+
+    std::set<std::string> valid_protocols{"silo", "silo_hv", "tictoc"};
+
+    if (help) {
+        printf("%s", cmd_args.help().c_str());
+        std::cout << std::endl << "Valid concurrency control protocols:  ";
+        for (auto&& p : valid_protocols) std::cout << p << "  ";
+        std::cout << std::endl;
+        return 0;
+    }
+
+    garner::TxnProtocol protocol;
+    if (protocol_str == "silo")
+        protocol = garner::PROTOCOL_SILO;
+    else if (protocol_str == "silo_hv")
+        protocol = garner::PROTOCOL_SILO_HV;
+    else if (protocol_str == "tictoc")
+        protocol = garner::PROTOCOL_TICTOC;
+    else {
+        std::cerr << "Error: unrecognized concurrency control protocol: "
+                  << protocol_str << std::endl;
+        return 1;
+    }
+
+    if (NUM_TXNS_PER_THREAD < 10) {
+        std::cerr << "Error: number of txns per thread too small "
+                  << NUM_TXNS_PER_THREAD << std::endl;
+        return 1;
+    }
+
+    for (unsigned round = 0; round < NUM_ROUNDS; ++round) {
+        std::cout << "Round " << round << " --" << std::endl;
+        snapshot_test_round(protocol);
+    }
+
+    return 0;
+}
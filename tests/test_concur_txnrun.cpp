@@ -33,6 +33,10 @@ static unsigned NUM_ROUNDS = 1;
 static unsigned NUM_THREADS = 8;
 static size_t NUM_OPS_PER_THREAD = 12000;
 static size_t MAX_OPS_PER_TXN = 30;
+static unsigned HV_MAX_HEIGHT = 0;
+static unsigned HV_STRIPE_HEIGHT = 0;
+static bool READ_ONLY_SCANS = false;
+static bool HOT_LOCKING = false;
 
 static void client_thread_func(unsigned tidx, garner::Garner* gn,
                                uint64_t pre_putval,
@@ -41,7 +45,7 @@ static void client_thread_func(unsigned tidx, garner::Garner* gn,
                                std::atomic<uint64_t>* ser_counter,
                                std::latch* init_barrier) {
     reqs->clear();
-    reqs->reserve(NUM_OPS_PER_THREAD);
+    reqs->reserve(2 * NUM_OPS_PER_THREAD);
 
     std::random_device rd;
     std::mt19937 gen(rd());
@@ -49,15 +53,17 @@ static void client_thread_func(unsigned tidx, garner::Garner* gn,
     uint64_t putval = pre_putval;
     std::vector<std::string> putvec(*pre_putvec);
 
-    std::uniform_int_distribution<unsigned> rand_op_type(1, 3);
+    std::uniform_int_distribution<unsigned> rand_op_type(1, 5);
     std::uniform_int_distribution<unsigned> rand_get_source(1, 2);
     std::uniform_int_distribution<size_t> rand_idx(
         0, NUM_OPS_PER_THREAD + NUM_OPS_WARMUP - 1);
 
-    auto GenRandomReq = [&](bool scan_only) -> GarnerReq {
-        // randomly pick an op type
-        unsigned op_choice = scan_only ? 3 : rand_op_type(gen);
-        GarnerOp op = (op_choice == 1) ? GET : (op_choice == 2) ? PUT : SCAN;
+    // an Update or a Merge is recorded as a Get of the value its function
+    // last saw followed by a Put of its result, hence generated as a Put
+    auto GenRandomReq = [&](unsigned op_choice) -> GarnerReq {
+        GarnerOp op = (op_choice == 1)                     ? GET
+                      : (op_choice == 2 || op_choice >= 4) ? PUT
+                                                           : SCAN;
 
         if (op == GET) {
             // randomly pick should-found Get vs. unsure Get
@@ -101,7 +107,8 @@ static void client_thread_func(unsigned tidx, garner::Garner* gn,
     std::uniform_int_distribution<size_t> rand_txn_ops(1, MAX_OPS_PER_TXN);
     std::uniform_int_distribution<size_t> rand_txn_ops_scan(
         1, MAX_OPS_PER_TXN / 10);
-    std::uniform_int_distribution<unsigned> rand_non_scan(0, 4);
+    std::uniform_int_distribution<unsigned> rand_non_scan(
+        0, READ_ONLY_SCANS ? 5 : 4);
 
     std::string get_buf = "";
     std::vector<std::tuple<std::string, std::string>> scan_result;
@@ -113,22 +120,58 @@ static void client_thread_func(unsigned tidx, garner::Garner* gn,
 
     size_t curr_ops = 0;
     while (curr_ops < NUM_OPS_PER_THREAD) {
-        // generate scan only or not decision
+        // generate scan only or not decision; if enabled, an extra fraction
+        // of scan-only transactions exercises the read-only mode
         unsigned non_scan = rand_non_scan(gen);
-        bool scan_txn = (non_scan == 0);
+        bool read_only_txn = (non_scan == 5);
+        bool scan_txn = (non_scan == 0) || read_only_txn;
 
         // generate number of ops for this transaction
         size_t txn_ops = scan_txn ? rand_txn_ops_scan(gen) : rand_txn_ops(gen);
         if (curr_ops + txn_ops > NUM_OPS_PER_THREAD)
             txn_ops = NUM_OPS_PER_THREAD - curr_ops;
 
-        auto* txn = gn->StartTxn();
+        auto* txn = gn->StartTxn(read_only_txn ? garner::TXN_READ_ONLY
+                                               : garner::TXN_READ_WRITE);
 
         // generate random requests
+        size_t txn_reqs_start = reqs->size();
         for (size_t j = 0; j < txn_ops; ++j) {
-            GarnerReq req = GenRandomReq(scan_txn);
-
-            if (req.op == GET) {
+            // randomly pick an op type
+            unsigned op_choice = scan_txn ? 3 : rand_op_type(gen);
+            GarnerReq req = GenRandomReq(op_choice);
+
+            if (op_choice == 4) {
+                // the function may get re-run upon repair, overwriting what
+                // it saw; reqs has reserved enough capacity not to move
+                reqs->push_back(GarnerReq(GET, req.key));
+                size_t get_idx = reqs->size() - 1;
+                std::string val = req.value;
+                gn->Update(
+                    req.key,
+                    [reqs, get_idx, val](const std::string& value,
+                                         bool found) {
+                        reqs->at(get_idx).value = value;
+                        reqs->at(get_idx).get_found = found;
+                        return val;
+                    },
+                    txn);
+                putvec.push_back(req.key);
+            } else if (op_choice == 5) {
+                // applied at commit time, if not read back before that
+                reqs->push_back(GarnerReq(GET, req.key));
+                size_t get_idx = reqs->size() - 1;
+                gn->Merge(
+                    req.key, req.value,
+                    [reqs, get_idx](const std::string& value, bool found,
+                                    const std::string& delta) {
+                        reqs->at(get_idx).value = value;
+                        reqs->at(get_idx).get_found = found;
+                        return delta;
+                    },
+                    txn);
+                putvec.push_back(req.key);
+            } else if (req.op == GET) {
                 bool found;
                 gn->Get(req.key, get_buf, found, txn);
                 req.value = get_buf;
@@ -149,9 +192,9 @@ static void client_thread_func(unsigned tidx, garner::Garner* gn,
 
         bool committed = gn->FinishTxn(txn, ser_counter, &ser_order);
         // save commit/abort result
-        for (size_t j = 0; j < txn_ops; ++j) {
-            reqs->at(curr_ops + j).committed = committed;
-            reqs->at(curr_ops + j).ser_order = ser_order;
+        for (size_t j = txn_reqs_start; j < reqs->size(); ++j) {
+            reqs->at(j).committed = committed;
+            reqs->at(j).ser_order = ser_order;
         }
 
         curr_ops += txn_ops;
@@ -387,11 +430,14 @@ static void serializability_check(
 
 static void concurrency_test_round(garner::TxnProtocol protocol,
                                    bool static_mode) {
-    auto* gn = garner::Garner::Open(TEST_DEGREE, protocol);
+    auto* gn = garner::Garner::Open(TEST_DEGREE, protocol, HV_MAX_HEIGHT, 0,
+                                    HV_STRIPE_HEIGHT, HOT_LOCKING);
 
     std::cout << " Degree=" << TEST_DEGREE << " #threads=" << NUM_THREADS
               << " #ops/thread=" << NUM_OPS_PER_THREAD
-              << " static=" << (static_mode ? "yes" : "no") << std::endl;
+              << " static=" << (static_mode ? "yes" : "no")
+              << " read_only=" << (READ_ONLY_SCANS ? "yes" : "no")
+              << " hot_locking=" << (HOT_LOCKING ? "yes" : "no") << std::endl;
 
     std::atomic<uint64_t> ser_counter{1};
 
@@ -468,10 +514,22 @@ int main(int argc, char* argv[]) {
         "m,max_ops_txn", "max number of ops per transaction",
         cxxopts::value<size_t>(MAX_OPS_PER_TXN)->default_value("30"))(
         "s,static", "if set, disallow on-the-fly insertions",
-        cxxopts::value<bool>(static_mode)->default_value("false"));
+        cxxopts::value<bool>(static_mode)->default_value("false"))(
+        "v,hv_max_height", "max height of pages tracked by HV, 0 means all",
+        cxxopts::value<unsigned>(HV_MAX_HEIGHT)->default_value("0"))(
+        "e,hv_stripe_height",
+        "min height of pages striping hv_sem per core, 0 means none",
+        cxxopts::value<unsigned>(HV_STRIPE_HEIGHT)->default_value("0"))(
+        "y,read_only", "also run a fraction of scan-only transactions in "
+                       "read-only mode",
+        cxxopts::value<bool>(READ_ONLY_SCANS)->default_value("false"))(
+        "k,hot_locking", "lock hot records at access time in Silo protocols",
+        cxxopts::value<bool>(HOT_LOCKING)->default_value("false"));
     auto result = cmd_args.parse(argc, argv);
 
-    std::set<std::string> valid_protocols{"none", "silo", "silo_hv"};
+    std::set<std::string> valid_protocols{
+        "none",       "silo",        "silo_hv", "silo_ad",
+        "2pl_nowait", "2pl_waitdie", "tictoc"};
 
     if (help) {
         printf("%s", cmd_args.help().c_str());
@@ -488,6 +546,14 @@ int main(int argc, char* argv[]) {
         protocol = garner::PROTOCOL_SILO;
     else if (protocol_str == "silo_hv")
         protocol = garner::PROTOCOL_SILO_HV;
+    else if (protocol_str == "silo_ad")
+        protocol = garner::PROTOCOL_SILO_AD;
+    else if (protocol_str == "2pl_nowait")
+        protocol = garner::PROTOCOL_2PL_NOWAIT;
+    else if (protocol_str == "2pl_waitdie")
+        protocol = garner::PROTOCOL_2PL_WAITDIE;
+    else if (protocol_str == "tictoc")
+        protocol = garner::PROTOCOL_TICTOC;
     else {
         std::cerr << "Error: unrecognized concurrency control protocol: "
                   << protocol_str << std::endl;
@@ -87,6 +87,48 @@ static void single_test_round(garner::TxnProtocol protocol) {
         refmap[key] = val;
     };
 
+    auto CheckedUpdate = [&](std::string key, std::string val,
+                             garner::TxnCxt<std::string, std::string>* txn) {
+        // std::cout << "Update " << key << " " << val << std::endl;
+        bool reffound = refmap.contains(key);
+        std::string refval = reffound ? refmap[key] : "";
+        gn->Update(
+            key,
+            [key, val, reffound, refval](const std::string& old_val,
+                                         bool found) {
+                if (found != reffound || old_val != refval) {
+                    throw FuzzTestException(
+                        "Update mismatch: key=" + key + " val=" + old_val +
+                        " refval=" + refval);
+                }
+                return old_val + val;
+            },
+            txn);
+        if (!reffound) refvec.push_back(key);
+        refmap[key] = refval + val;
+    };
+
+    auto CheckedMerge = [&](std::string key, std::string val,
+                            garner::TxnCxt<std::string, std::string>* txn) {
+        // std::cout << "Merge " << key << " " << val << std::endl;
+        bool reffound = refmap.contains(key);
+        std::string refval = reffound ? refmap[key] : "";
+        gn->Merge(
+            key, val,
+            [key, reffound, refval](const std::string& old_val, bool found,
+                                    const std::string& delta) {
+                if (found != reffound || old_val != refval) {
+                    throw FuzzTestException(
+                        "Merge mismatch: key=" + key + " val=" + old_val +
+                        " refval=" + refval);
+                }
+                return old_val + delta;
+            },
+            txn);
+        if (!reffound) refvec.push_back(key);
+        refmap[key] = refval + val;
+    };
+
     auto CheckedGet = [&](const std::string& key,
                           garner::TxnCxt<std::string, std::string>* txn) {
         std::string val = "", refval = "null";
@@ -163,8 +205,10 @@ static void single_test_round(garner::TxnProtocol protocol) {
     // stats = gn->GatherStats(true);
     // std::cout << stats << std::endl;
 
-    // explicit transactions
+    // explicit transactions, with some of the Puts as Updates or Merges
+    // building on the current value
     std::uniform_int_distribution<size_t> rand_txn_ops(1, MAX_OPS_PER_TXN);
+    std::uniform_int_distribution<unsigned> rand_write_type(0, 2);
     size_t curr_ops = num_implicit;
     while (curr_ops < NUM_OPS) {
         // generate number of ops for this transaction
@@ -179,8 +223,15 @@ static void single_test_round(garner::TxnProtocol protocol) {
 
             if (req.op == GET)
                 CheckedGet(req.key, txn);
-            else if (req.op == PUT)
-                CheckedPut(req.key, req.value, txn);
+            else if (req.op == PUT) {
+                unsigned write_type = rand_write_type(gen);
+                if (write_type == 1)
+                    CheckedUpdate(req.key, req.value, txn);
+                else if (write_type == 2)
+                    CheckedMerge(req.key, req.value, txn);
+                else
+                    CheckedPut(req.key, req.value, txn);
+            }
             else
                 CheckedScan(req.key, req.rkey, txn);
         }
@@ -192,6 +243,92 @@ static void single_test_round(garner::TxnProtocol protocol) {
         curr_ops += txn_ops;
     }
 
+    // read-only transactions reject writes but still commit their reads
+    if (protocol != garner::PROTOCOL_NONE) {
+        auto* txn = gn->StartTxn(garner::TXN_READ_ONLY);
+        GarnerReq req = GenRandomReq();
+        CheckedGet(req.key, txn);
+        CheckedScan(req.key, req.key, txn);
+
+        bool rejected = false;
+        try {
+            gn->Put(req.key, req.value, txn);
+        } catch (const std::exception&) {
+            rejected = true;
+        }
+        if (!rejected)
+            throw FuzzTestException("Put accepted by read-only transaction");
+
+        bool committed = gn->FinishTxn(txn);
+        if (!committed)
+            throw FuzzTestException(
+                "read-only transaction aborted with single thread");
+    }
+
+    // a key read as absent through a phantom record that another transaction
+    // then fills must fail the reader's commit, since the reader may have
+    // also seen other writes of the filler
+    for (auto mode : {garner::TXN_READ_WRITE, garner::TXN_READ_ONLY}) {
+        if (protocol == garner::PROTOCOL_NONE) break;
+
+        std::string pkey, ykey;
+        do {
+            pkey = gen_rand_string(gen, KEY_LEN);
+        } while (refmap.contains(pkey));
+        do {
+            ykey = gen_rand_string(gen, KEY_LEN);
+        } while (refmap.contains(ykey) || ykey == pkey);
+
+        auto* filler = gn->StartTxn();
+        gn->Put(pkey, "filled", filler);
+
+        auto* reader = gn->StartTxn(mode);
+        std::string val;
+        bool found;
+        gn->Get(pkey, val, found, reader);
+        if (found)
+            throw FuzzTestException("Get found uncommitted insert: key=" +
+                                    pkey);
+
+        gn->Put(ykey, "filled", filler);
+        if (!gn->FinishTxn(filler))
+            throw FuzzTestException("filler aborted with no conflict");
+        refmap[pkey] = "filled";
+        refmap[ykey] = "filled";
+
+        gn->Get(ykey, val, found, reader);
+        if (gn->FinishTxn(reader))
+            throw FuzzTestException(
+                "reader committed after phantom got filled: key=" + pkey);
+    }
+
+    // autocommit writes must not wait on hot record locks, not even ones
+    // held by an open transaction of the same thread
+    if (protocol == garner::PROTOCOL_SILO ||
+        protocol == garner::PROTOCOL_SILO_HV ||
+        protocol == garner::PROTOCOL_SILO_AD) {
+        auto* hgn = garner::Garner::Open(TEST_DEGREE, protocol, 0, 0, 0, true);
+        std::string hkey = gen_rand_string(gen, KEY_LEN);
+        hgn->Put(hkey, "0");
+
+        for (unsigned i = 1; i <= 16; ++i) {
+            auto* txn = hgn->StartTxn();
+            std::string val;
+            bool found;
+            hgn->Get(hkey, val, found, txn);
+            hgn->Put(hkey, std::to_string(i));
+            hgn->FinishTxn(txn);
+        }
+
+        std::string val;
+        bool found;
+        hgn->Get(hkey, val, found);
+        if (!found || val != "16")
+            throw FuzzTestException("autocommit write lost on hot key: key=" +
+                                    hkey);
+        delete hgn;
+    }
+
     // stats = gn->GatherStats(true);
     // std::cout << stats << std::endl;
 
@@ -216,7 +353,9 @@ int main(int argc, char* argv[]) {
         cxxopts::value<size_t>(MAX_OPS_PER_TXN)->default_value("20"));
     auto result = cmd_args.parse(argc, argv);
 
-    std::set<std::string> valid_protocols{"none", "silo", "silo_hv"};
+    std::set<std::string> valid_protocols{
+        "none",       "silo",        "silo_hv", "silo_ad",
+        "2pl_nowait", "2pl_waitdie", "tictoc"};
 
     if (help) {
         printf("%s", cmd_args.help().c_str());
@@ -233,6 +372,14 @@ int main(int argc, char* argv[]) {
         protocol = garner::PROTOCOL_SILO;
     else if (protocol_str == "silo_hv")
         protocol = garner::PROTOCOL_SILO_HV;
+    else if (protocol_str == "silo_ad")
+        protocol = garner::PROTOCOL_SILO_AD;
+    else if (protocol_str == "2pl_nowait")
+        protocol = garner::PROTOCOL_2PL_NOWAIT;
+    else if (protocol_str == "2pl_waitdie")
+        protocol = garner::PROTOCOL_2PL_WAITDIE;
+    else if (protocol_str == "tictoc")
+        protocol = garner::PROTOCOL_TICTOC;
     else {
         std::cerr << "Error: unrecognized concurrency control protocol: "
                   << protocol_str << std::endl;
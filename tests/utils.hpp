@@ -1,7 +1,12 @@
+#include <atomic>
 #include <cassert>
+#include <map>
 #include <random>
 #include <stdexcept>
 #include <string>
+#include <vector>
+
+#include "garner.hpp"
 
 #pragma once
 
@@ -35,6 +40,57 @@ static std::string gen_rand_string(std::mt19937& gen, size_t len) {
     return str;
 }
 
+/**
+ * Fixed-width numbered account key, so that key order matches index order.
+ */
+inline std::string account_key(size_t idx) {
+    std::string num = std::to_string(idx);
+    return "acct-" + std::string(6 - num.size(), '0') + num;
+}
+
+/**
+ * Fixed-width numbered counter key, so that key order matches index order.
+ */
+inline std::string counter_key(size_t idx) {
+    std::string num = std::to_string(idx);
+    return "ctr-" + std::string(4 - num.size(), '0') + num;
+}
+
+/**
+ * Put num numbered keys with values given by val_fn, and return what got
+ * put as a reference map.
+ */
+template <typename ValFn>
+std::map<std::string, std::string> populate_keys(
+    garner::Garner* gn, std::string (*key_fn)(size_t), size_t num,
+    ValFn val_fn) {
+    std::map<std::string, std::string> refmap;
+    for (size_t i = 0; i < num; ++i) {
+        std::string val = val_fn(i);
+        gn->Put(key_fn(i), val);
+        refmap[key_fn(i)] = std::move(val);
+    }
+    return refmap;
+}
+
+/**
+ * Check that each numbered counter ended up at its expected value.
+ */
+inline void check_counters(garner::Garner* gn,
+                           const std::vector<std::atomic<size_t>>& expected) {
+    for (size_t i = 0; i < expected.size(); ++i) {
+        std::string val;
+        bool found;
+        gn->Get(counter_key(i), val, found);
+        if (!found) throw FuzzTestException("counter missing after run");
+        if (std::stoul(val) != expected[i]) {
+            throw FuzzTestException("counter " + std::to_string(i) + " is " +
+                                    val + ", expected " +
+                                    std::to_string(expected[i]));
+        }
+    }
+}
+
 /**
  * Garner request struct for testing.
  */